@@ -0,0 +1,237 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_BinaryCursor_hh__
+#define avro_BinaryCursor_hh__
+
+#include <cstdint>
+#include <cstring>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#else
+#include "boost/utility/string_view.hpp"
+#endif
+
+#include "Config.hh"
+#include "Decoder.hh"
+#include "Exception.hh"
+#include "Zigzag.hh"
+
+namespace avro {
+
+#if __cplusplus >= 201703L
+typedef std::string_view string_view;
+#else
+typedef boost::string_view string_view;
+#endif
+
+/**
+ * Reads Avro binary encoded data directly out of contiguous memory.
+ * Strings, bytes and fixed are returned as views into that memory, so
+ * nothing is copied. The methods follow those of Decoder, so that the
+ * same code can skip data with either.
+ */
+class BinaryCursor {
+    const uint8_t *next_;
+    const uint8_t *end_;
+
+    void need(size_t n) const {
+        if (static_cast<size_t>(end_ - next_) < n) {
+            throw Exception("Unexpected end of data");
+        }
+    }
+
+    uint64_t decodeVarint() {
+        uint64_t encoded = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            need(1);
+            uint8_t u = *next_++;
+            encoded |= static_cast<uint64_t>(u & 0x7f) << shift;
+            if (!(u & 0x80)) {
+                return encoded;
+            }
+        }
+        throw Exception("Invalid Avro varint");
+    }
+
+    size_t decodeLength() {
+        int64_t len = decodeLong();
+        if (len < 0) {
+            throw Exception("Cannot have negative length");
+        }
+        return static_cast<size_t>(len);
+    }
+
+    size_t skipBlocks() {
+        for (;;) {
+            int64_t n = decodeLong();
+            if (n >= 0) {
+                return static_cast<size_t>(n);
+            }
+            skipFixed(decodeLength());
+        }
+    }
+
+public:
+    BinaryCursor(const uint8_t *data, const uint8_t *end) : next_(data), end_(end) {}
+
+    /// Returns the address of the next byte to be read.
+    const uint8_t *position() const { return next_; }
+
+    /// Returns the address past the last byte of the data.
+    const uint8_t *end() const { return end_; }
+
+    bool decodeBool() {
+        need(1);
+        uint8_t v = *next_++;
+        if (v > 1) {
+            throw Exception("Invalid value for bool");
+        }
+        return v == 1;
+    }
+
+    int32_t decodeInt() {
+        int64_t val = decodeLong();
+        if (val < INT32_MIN || val > INT32_MAX) {
+            throw Exception("Value out of range for Avro int");
+        }
+        return static_cast<int32_t>(val);
+    }
+
+    int64_t decodeLong() {
+        return decodeZigzag64(decodeVarint());
+    }
+
+    float decodeFloat() {
+        float result;
+        need(sizeof(result));
+        std::memcpy(&result, next_, sizeof(result));
+        next_ += sizeof(result);
+        return result;
+    }
+
+    double decodeDouble() {
+        double result;
+        need(sizeof(result));
+        std::memcpy(&result, next_, sizeof(result));
+        next_ += sizeof(result);
+        return result;
+    }
+
+    string_view decodeString() {
+        return decodeFixed(decodeLength());
+    }
+
+    string_view decodeBytes() {
+        return decodeFixed(decodeLength());
+    }
+
+    string_view decodeFixed(size_t n) {
+        need(n);
+        const char *p = reinterpret_cast<const char *>(next_);
+        next_ += n;
+        return string_view(p, n);
+    }
+
+    void skipString() { skipFixed(decodeLength()); }
+
+    void skipBytes() { skipFixed(decodeLength()); }
+
+    void skipFixed(size_t n) {
+        need(n);
+        next_ += n;
+    }
+
+    size_t decodeEnum() { return static_cast<size_t>(decodeLong()); }
+
+    size_t decodeUnionIndex() { return static_cast<size_t>(decodeLong()); }
+
+    /// Skips the blocks of an array that carry their size in bytes. Returns
+    /// the number of items in the next block, which must be skipped one by
+    /// one, or 0 at the end of the array.
+    size_t skipArray() { return skipBlocks(); }
+
+    /// Like skipArray(), for maps.
+    size_t skipMap() { return skipBlocks(); }
+
+    /// Returns the number of items in the next block of an array or map,
+    /// 0 at the end.
+    size_t decodeItemCount() {
+        int64_t n = decodeLong();
+        if (n < 0) {
+            decodeLong();
+            return static_cast<size_t>(-n);
+        }
+        return static_cast<size_t>(n);
+    }
+};
+
+/**
+ * A binary Decoder over contiguous memory, read through a BinaryCursor.
+ * Unlike binaryDecoder() it needs no stream and no allocation, so it can
+ * be made on the stack to decode a single value with codec_traits.
+ */
+class CursorDecoder : public Decoder {
+    BinaryCursor c_;
+
+public:
+    CursorDecoder(const uint8_t *data, const uint8_t *end) : c_(data, end) {}
+
+    /// Returns the address of the next byte to be read.
+    const uint8_t *position() const { return c_.position(); }
+
+    void init(InputStream &) final {
+        throw Exception("CursorDecoder reads only the memory it was made with");
+    }
+    void decodeNull() final {}
+    bool decodeBool() final { return c_.decodeBool(); }
+    int32_t decodeInt() final { return c_.decodeInt(); }
+    int64_t decodeLong() final { return c_.decodeLong(); }
+    float decodeFloat() final { return c_.decodeFloat(); }
+    double decodeDouble() final { return c_.decodeDouble(); }
+    void decodeString(std::string &value) final {
+        string_view v = c_.decodeString();
+        value.assign(v.data(), v.size());
+    }
+    void skipString() final { c_.skipString(); }
+    void decodeBytes(std::vector<uint8_t> &value) final {
+        string_view v = c_.decodeBytes();
+        value.assign(v.begin(), v.end());
+    }
+    void skipBytes() final { c_.skipBytes(); }
+    void decodeFixed(size_t n, std::vector<uint8_t> &value) final {
+        string_view v = c_.decodeFixed(n);
+        value.assign(v.begin(), v.end());
+    }
+    void skipFixed(size_t n) final { c_.skipFixed(n); }
+    size_t decodeEnum() final { return c_.decodeEnum(); }
+    size_t arrayStart() final { return c_.decodeItemCount(); }
+    size_t arrayNext() final { return c_.decodeItemCount(); }
+    size_t skipArray() final { return c_.skipArray(); }
+    size_t mapStart() final { return c_.decodeItemCount(); }
+    size_t mapNext() final { return c_.decodeItemCount(); }
+    size_t skipMap() final { return c_.skipMap(); }
+    size_t decodeUnionIndex() final { return c_.decodeUnionIndex(); }
+    void drain() final {}
+    bool isBinary() const final { return true; }
+};
+
+} // namespace avro
+
+#endif
@@ -0,0 +1,240 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_Compare_hh__
+#define avro_Compare_hh__
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "boost/container/container_fwd.hpp"
+
+#include "Config.hh"
+#include "Exception.hh"
+#include "Specific.hh"
+
+/**
+ * Comparison and hashing of specific types following the sort order of
+ * the Avro specification. compare() returns a negative number, zero or a
+ * positive number as its first argument sorts before, together with or
+ * after its second. Types generated by avrogencpp --compare provide
+ * compare() and hashValue() overloads of their own, which are found by
+ * argument dependent lookup.
+ */
+namespace avro {
+
+inline int compare(const null &, const null &) {
+    return 0;
+}
+
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, int>::type
+compare(T a, T b) {
+    return a < b ? -1 : (b < a ? 1 : 0);
+}
+
+inline int compareBytes(const void *a, size_t na, const void *b, size_t nb) {
+    int r = (na == 0 || nb == 0) ? 0 : std::memcmp(a, b, std::min(na, nb));
+    if (r == 0) {
+        return na < nb ? -1 : (nb < na ? 1 : 0);
+    }
+    return r < 0 ? -1 : 1;
+}
+
+/// Strings sort by Unicode code point, which is the byte order of UTF-8.
+template<typename Tr, typename A>
+int compare(const std::basic_string<char, Tr, A> &a, const std::basic_string<char, Tr, A> &b) {
+    return compareBytes(a.data(), a.size(), b.data(), b.size());
+}
+
+template<typename A>
+int compare(const std::vector<uint8_t, A> &a, const std::vector<uint8_t, A> &b) {
+    return compareBytes(a.data(), a.size(), b.data(), b.size());
+}
+
+template<size_t N>
+int compare(const std::array<uint8_t, N> &a, const std::array<uint8_t, N> &b) {
+    return compareBytes(a.data(), N, b.data(), N);
+}
+
+/// Avro maps have no order, so they may only be part of records as
+/// ignored fields.
+template<typename K, typename T, typename C, typename A>
+int compare(const std::map<K, T, C, A> &, const std::map<K, T, C, A> &) {
+    throw Exception("Avro maps cannot be compared");
+}
+
+template<typename K, typename T, typename H, typename E, typename A>
+int compare(const std::unordered_map<K, T, H, E, A> &, const std::unordered_map<K, T, H, E, A> &) {
+    throw Exception("Avro maps cannot be compared");
+}
+
+template<typename Tr, typename SA, typename T, typename A>
+int compare(const std::vector<std::pair<std::basic_string<char, Tr, SA>, T>, A> &,
+            const std::vector<std::pair<std::basic_string<char, Tr, SA>, T>, A> &) {
+    throw Exception("Avro maps cannot be compared");
+}
+
+template<typename T, typename A>
+int compare(const std::vector<T, A> &a, const std::vector<T, A> &b);
+
+/// Arrays held in Boost.Container vectors, defined in SpecificContainers.hh.
+template<typename T, size_t N, typename... P>
+int compare(const boost::container::small_vector<T, N, P...> &a,
+            const boost::container::small_vector<T, N, P...> &b);
+template<typename T, size_t N, typename... P>
+int compare(const boost::container::static_vector<T, N, P...> &a,
+            const boost::container::static_vector<T, N, P...> &b);
+
+/// Arrays sort element by element, a prefix before the longer array. All
+/// the containers that may hold arrays share this order.
+template<typename V>
+int compareArrays(const V &a, const V &b) {
+    size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; ++i) {
+        int r = compare(a[i], b[i]);
+        if (r != 0) {
+            return r;
+        }
+    }
+    return a.size() < b.size() ? -1 : (b.size() < a.size() ? 1 : 0);
+}
+
+template<typename T, typename A>
+int compare(const std::vector<T, A> &a, const std::vector<T, A> &b) {
+    return compareArrays(a, b);
+}
+
+inline void hashCombine(size_t &seed, size_t h) {
+    seed ^= h + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+/// FNV-1a over the given bytes.
+inline size_t hashBytes(const void *p, size_t n) {
+    const uint8_t *b = static_cast<const uint8_t *>(p);
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; ++i) {
+        h = (h ^ b[i]) * 1099511628211ULL;
+    }
+    return static_cast<size_t>(h);
+}
+
+inline size_t hashValue(const null &) {
+    return 0;
+}
+
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, size_t>::type
+hashValue(T v) {
+    return std::hash<T>()(v);
+}
+
+template<typename T>
+typename std::enable_if<std::is_enum<T>::value, size_t>::type
+hashValue(T v) {
+    typedef typename std::underlying_type<T>::type U;
+    return std::hash<U>()(static_cast<U>(v));
+}
+
+template<typename Tr, typename A>
+size_t hashValue(const std::basic_string<char, Tr, A> &s) {
+    return hashBytes(s.data(), s.size());
+}
+
+template<typename A>
+size_t hashValue(const std::vector<uint8_t, A> &v) {
+    return hashBytes(v.data(), v.size());
+}
+
+template<size_t N>
+size_t hashValue(const std::array<uint8_t, N> &v) {
+    return hashBytes(v.data(), N);
+}
+
+template<typename K, typename T, typename C, typename A>
+size_t hashValue(const std::map<K, T, C, A> &m);
+
+template<typename K, typename T, typename H, typename E, typename A>
+size_t hashValue(const std::unordered_map<K, T, H, E, A> &m);
+
+/// The entries of maps held flat, in the order they are held.
+template<typename K, typename T>
+size_t hashValue(const std::pair<K, T> &e);
+
+template<typename T, typename A>
+size_t hashValue(const std::vector<T, A> &v);
+
+template<typename T, size_t N, typename... P>
+size_t hashValue(const boost::container::small_vector<T, N, P...> &v);
+template<typename T, size_t N, typename... P>
+size_t hashValue(const boost::container::static_vector<T, N, P...> &v);
+
+template<typename V>
+size_t hashArray(const V &v) {
+    size_t h = v.size();
+    for (const auto &e : v) {
+        hashCombine(h, hashValue(e));
+    }
+    return h;
+}
+
+template<typename T, typename A>
+size_t hashValue(const std::vector<T, A> &v) {
+    return hashArray(v);
+}
+
+template<typename K, typename T, typename C, typename A>
+size_t hashValue(const std::map<K, T, C, A> &m) {
+    size_t h = m.size();
+    for (const auto &e : m) {
+        hashCombine(h, hashValue(e.first));
+        hashCombine(h, hashValue(e.second));
+    }
+    return h;
+}
+
+/// Equal unordered maps may hold their entries in different orders, so
+/// the entries' hashes are combined in a way that does not depend on it.
+template<typename K, typename T, typename H, typename E, typename A>
+size_t hashValue(const std::unordered_map<K, T, H, E, A> &m) {
+    size_t h = m.size();
+    for (const auto &e : m) {
+        h += hashValue(e);
+    }
+    return h;
+}
+
+template<typename K, typename T>
+size_t hashValue(const std::pair<K, T> &e) {
+    size_t h = hashValue(e.first);
+    hashCombine(h, hashValue(e.second));
+    return h;
+}
+
+} // namespace avro
+
+#endif
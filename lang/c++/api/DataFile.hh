@@ -116,11 +116,15 @@ public:
     }
     /**
      * Constructs a data file writer with the given sync interval and name.
+     * If \p sizedBlocks is true, the blocks of arrays and maps are written
+     * with their sizes in bytes so that readers can skip them quickly.
      */
     DataFileWriterBase(const char *filename, const ValidSchema &schema,
-                       size_t syncInterval, Codec codec = NULL_CODEC);
+                       size_t syncInterval, Codec codec = NULL_CODEC,
+                       bool sizedBlocks = false);
     DataFileWriterBase(std::unique_ptr<OutputStream> outputStream,
-                       const ValidSchema &schema, size_t syncInterval, Codec codec);
+                       const ValidSchema &schema, size_t syncInterval, Codec codec,
+                       bool sizedBlocks = false);
 
     ~DataFileWriterBase();
     /**
@@ -149,13 +153,15 @@ class DataFileWriter : boost::noncopyable {
 
 public:
     /**
-     * Constructs a new data file.
+     * Constructs a new data file. See DataFileWriterBase for \p sizedBlocks.
      */
     DataFileWriter(const char *filename, const ValidSchema &schema,
-                   size_t syncInterval = 16 * 1024, Codec codec = NULL_CODEC) : base_(new DataFileWriterBase(filename, schema, syncInterval, codec)) {}
+                   size_t syncInterval = 16 * 1024, Codec codec = NULL_CODEC,
+                   bool sizedBlocks = false) : base_(new DataFileWriterBase(filename, schema, syncInterval, codec, sizedBlocks)) {}
 
     DataFileWriter(std::unique_ptr<OutputStream> outputStream, const ValidSchema &schema,
-                   size_t syncInterval = 16 * 1024, Codec codec = NULL_CODEC) : base_(new DataFileWriterBase(std::move(outputStream), schema, syncInterval, codec)) {}
+                   size_t syncInterval = 16 * 1024, Codec codec = NULL_CODEC,
+                   bool sizedBlocks = false) : base_(new DataFileWriterBase(std::move(outputStream), schema, syncInterval, codec, sizedBlocks)) {}
 
     /**
      * Writes the given piece of data into the file.
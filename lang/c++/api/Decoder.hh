@@ -41,6 +41,8 @@
 
 namespace avro {
 
+class ResolvingDecoder;
+
 /**
  * Decoder is an interface implemented by every decoder capable
  * of decoding Avro data.
@@ -169,6 +171,16 @@ public:
     /// by the avro decoder. Similar set of problems occur if the Decoder
     /// consumes more than what it should.
     virtual void drain() = 0;
+
+    /// Returns true if this decoder reads the Avro binary encoding straight
+    /// from its input stream. For such decoders values of a known width,
+    /// such as floats, doubles and fixed, can be skipped as raw bytes.
+    virtual bool isBinary() const { return false; }
+
+    /// Returns this decoder as a ResolvingDecoder if it is one and
+    /// nullptr otherwise. Unlike a dynamic_cast, this costs no more
+    /// than a virtual call, so it suits per-record checks.
+    virtual ResolvingDecoder *asResolvingDecoder() { return nullptr; }
 };
 
 /**
@@ -188,6 +200,8 @@ public:
     /// be different. In order to avoid buffering and later use,
     /// we return the values in the writer's field order.
     virtual const std::vector<size_t> &fieldOrder() = 0;
+
+    ResolvingDecoder *asResolvingDecoder() final { return this; }
 };
 
 /**
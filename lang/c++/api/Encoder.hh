@@ -85,6 +85,15 @@ public:
     /// Encodes a UTF-8 string to the current stream.
     virtual void encodeString(const std::string &s) = 0;
 
+    /**
+     * Encodes a UTF-8 string of \p len bytes at \p s to the current
+     * stream. This default copies the string into a std::string; the
+     * binary encoders write it as it is.
+     */
+    virtual void encodeString(const char *s, size_t len) {
+        encodeString(std::string(s, len));
+    }
+
     /**
      * Encodes arbitrary binary data into the current stream as Avro "bytes"
      * data type.
@@ -151,6 +160,15 @@ using EncoderPtr = std::shared_ptr<Encoder>;
  */
 AVRO_DECL EncoderPtr binaryEncoder();
 
+/**
+ *  Returns an encoder that encodes binary Avro standard, writing the blocks
+ *  of arrays and maps with their sizes in bytes so that readers can skip
+ *  them without decoding their items. Blocks are buffered in memory until
+ *  they are complete; once more than \p maxBufferSize bytes are pending,
+ *  they are written out without sizes instead.
+ */
+AVRO_DECL EncoderPtr blockingBinaryEncoder(size_t maxBufferSize = 64 * 1024);
+
 /**
  *  Returns an encoder that validates sequence of calls to an underlying
  *  Encoder against the given schema.
@@ -20,6 +20,8 @@
 #define avro_Generic_hh__
 
 #include <boost/utility.hpp>
+#include <unordered_map>
+#include <vector>
 
 #include "Config.hh"
 #include "Decoder.hh"
@@ -32,11 +34,16 @@ namespace avro {
  * A utility class to read generic datum from decoders.
  */
 class AVRO_DECL GenericReader : boost::noncopyable {
+    /// Datums no longer in use, by the schema node they were built for.
+    typedef std::unordered_map<const Node *, std::vector<GenericDatum>> DatumPool;
+
     const ValidSchema schema_;
     const bool isResolving_;
     const DecoderPtr decoder_;
+    mutable DatumPool pool_;
 
-    static void read(GenericDatum &datum, Decoder &d, bool isResolving);
+    static void read(GenericDatum &datum, Decoder &d, bool isResolving,
+                     const NodePtr *schema = nullptr, DatumPool *pool = nullptr);
 
 public:
     /**
@@ -57,6 +64,41 @@ public:
      */
     void read(GenericDatum &datum) const;
 
+    /**
+     * Reads a value off the decoder into \p datum without rebuilding it.
+     * If \p datum already has the shape of the reader's schema, for
+     * instance because it was filled by an earlier call, the storage it
+     * holds is reused: strings and bytes keep their capacity and the
+     * elements of arrays and maps are decoded in place.
+     *
+     * Otherwise \p datum is replaced by one previously given to release(),
+     * if there is any. Array and map elements dropped because a record is
+     * shorter than the one before, as well as union branches that are no
+     * longer selected, are kept by the reader in the same way, so that
+     * decoding records of varying shape does not allocate and free
+     * their parts over and over.
+     */
+    void readInto(GenericDatum &datum) const;
+
+    /**
+     * Hands \p datum, which must have been read by readInto(), back to
+     * this reader so that later calls to readInto() can reuse its storage.
+     * \p datum is left as a null datum. Typically a batch of records is
+     * read, processed and then released as a whole.
+     */
+    void release(GenericDatum &datum) const;
+
+    /**
+     * Frees all the datums kept for reuse by readInto(), for instance
+     * after an unusually large batch.
+     */
+    void clearPool() const;
+
+    /**
+     * Returns the number of datums kept for reuse by readInto().
+     */
+    size_t pooled() const;
+
     /**
      * Drains any residual bytes in the input stream (e.g. because
      * reader's schema has no use of them) and return unused bytes
@@ -22,6 +22,7 @@
 #include <cstdint>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #if __cplusplus >= 201703L
@@ -57,11 +58,22 @@ namespace avro {
  * object should have the C++ type corresponding to one of the constituent
  * types of the union.
  *
+ * Values of the scalar types (boolean, int, long, float and double) are
+ * held inline in the datum; all others are held on the heap.
  */
 class AVRO_DECL GenericDatum {
 protected:
+    union Scalar {
+        bool boolValue;
+        int32_t intValue;
+        int64_t longValue;
+        float floatValue;
+        double doubleValue;
+    };
+
     Type type_;
     LogicalType logicalType_;
+    Scalar scalar_{};
 #if __cplusplus >= 201703L
     std::any value_;
 #else
@@ -76,10 +88,90 @@ protected:
 
     template<typename T>
     GenericDatum(Type t, LogicalType logicalType, const T &v)
-        : type_(t), logicalType_(logicalType), value_(v) {}
+        : type_(t), logicalType_(logicalType) {
+        assign(v);
+    }
 
     void init(const NodePtr &schema);
 
+    // Throws unless this datum holds a scalar of the Avro type t.
+    void checkScalar(Type t) const {
+        if (type_ != t) {
+            throwScalarMismatch(t);
+        }
+    }
+    [[noreturn]] void throwScalarMismatch(Type t) const;
+
+    // Where the value of type T is held, ignoring unions. The argument
+    // only selects the overload.
+    bool *valuePtr(bool *) {
+        checkScalar(AVRO_BOOL);
+        return &scalar_.boolValue;
+    }
+    int32_t *valuePtr(int32_t *) {
+        checkScalar(AVRO_INT);
+        return &scalar_.intValue;
+    }
+    int64_t *valuePtr(int64_t *) {
+        checkScalar(AVRO_LONG);
+        return &scalar_.longValue;
+    }
+    float *valuePtr(float *) {
+        checkScalar(AVRO_FLOAT);
+        return &scalar_.floatValue;
+    }
+    double *valuePtr(double *) {
+        checkScalar(AVRO_DOUBLE);
+        return &scalar_.doubleValue;
+    }
+    const bool *valuePtr(bool *) const {
+        checkScalar(AVRO_BOOL);
+        return &scalar_.boolValue;
+    }
+    const int32_t *valuePtr(int32_t *) const {
+        checkScalar(AVRO_INT);
+        return &scalar_.intValue;
+    }
+    const int64_t *valuePtr(int64_t *) const {
+        checkScalar(AVRO_LONG);
+        return &scalar_.longValue;
+    }
+    const float *valuePtr(float *) const {
+        checkScalar(AVRO_FLOAT);
+        return &scalar_.floatValue;
+    }
+    const double *valuePtr(double *) const {
+        checkScalar(AVRO_DOUBLE);
+        return &scalar_.doubleValue;
+    }
+
+    template<typename T>
+    T *valuePtr(T *) {
+#if __cplusplus >= 201703L
+        return std::any_cast<T>(&value_);
+#else
+        return boost::any_cast<T>(&value_);
+#endif
+    }
+
+    template<typename T>
+    const T *valuePtr(T *) const {
+#if __cplusplus >= 201703L
+        return std::any_cast<T>(&value_);
+#else
+        return boost::any_cast<T>(&value_);
+#endif
+    }
+
+    void assign(bool v) { scalar_.boolValue = v; }
+    void assign(int32_t v) { scalar_.intValue = v; }
+    void assign(int64_t v) { scalar_.longValue = v; }
+    void assign(float v) { scalar_.floatValue = v; }
+    void assign(double v) { scalar_.doubleValue = v; }
+
+    template<typename T>
+    void assign(const T &v) { value_ = v; }
+
 public:
     /**
      * The avro data type this datum holds.
@@ -122,12 +214,27 @@ public:
      */
     size_t unionBranch() const;
 
+    /**
+     * Returns the schema of the union, if this is a union.
+     * \sa isUnion().
+     */
+    const NodePtr &unionSchema() const;
+
     /**
      * Selects a new branch in the union if this is a union.
      * \sa isUnion().
      */
     void selectBranch(size_t branch);
 
+    /**
+     * Selects a new branch in the union if this is a union, taking the
+     * value of the branch from \p value, which must have been built for
+     * the schema of that branch. The value held so far is moved into
+     * \p value so that the caller can reuse it.
+     * \sa isUnion().
+     */
+    void selectBranch(size_t branch, GenericDatum &value);
+
     /// Makes a new AVRO_NULL datum.
     GenericDatum() : type_(AVRO_NULL), logicalType_(LogicalType::NONE) {}
 
@@ -135,31 +242,41 @@ public:
     /// We don't make this explicit constructor because we want to allow automatic conversion
     // NOLINTNEXTLINE(google-explicit-constructor)
     GenericDatum(bool v)
-        : type_(AVRO_BOOL), logicalType_(LogicalType::NONE), value_(v) {}
+        : type_(AVRO_BOOL), logicalType_(LogicalType::NONE) {
+        scalar_.boolValue = v;
+    }
 
     /// Makes a new AVRO_INT datum whose value is of type int32_t.
     /// We don't make this explicit constructor because we want to allow automatic conversion
     // NOLINTNEXTLINE(google-explicit-constructor)
     GenericDatum(int32_t v)
-        : type_(AVRO_INT), logicalType_(LogicalType::NONE), value_(v) {}
+        : type_(AVRO_INT), logicalType_(LogicalType::NONE) {
+        scalar_.intValue = v;
+    }
 
     /// Makes a new AVRO_LONG datum whose value is of type int64_t.
     /// We don't make this explicit constructor because we want to allow automatic conversion
     // NOLINTNEXTLINE(google-explicit-constructor)
     GenericDatum(int64_t v)
-        : type_(AVRO_LONG), logicalType_(LogicalType::NONE), value_(v) {}
+        : type_(AVRO_LONG), logicalType_(LogicalType::NONE) {
+        scalar_.longValue = v;
+    }
 
     /// Makes a new AVRO_FLOAT datum whose value is of type float.
     /// We don't make this explicit constructor because we want to allow automatic conversion
     // NOLINTNEXTLINE(google-explicit-constructor)
     GenericDatum(float v)
-        : type_(AVRO_FLOAT), logicalType_(LogicalType::NONE), value_(v) {}
+        : type_(AVRO_FLOAT), logicalType_(LogicalType::NONE) {
+        scalar_.floatValue = v;
+    }
 
     /// Makes a new AVRO_DOUBLE datum whose value is of type double.
     /// We don't make this explicit constructor because we want to allow automatic conversion
     // NOLINTNEXTLINE(google-explicit-constructor)
     GenericDatum(double v)
-        : type_(AVRO_DOUBLE), logicalType_(LogicalType::NONE), value_(v) {}
+        : type_(AVRO_DOUBLE), logicalType_(LogicalType::NONE) {
+        scalar_.doubleValue = v;
+    }
 
     /// Makes a new AVRO_STRING datum whose value is of type std::string.
     /// We don't make this explicit constructor because we want to allow automatic conversion
@@ -192,11 +309,7 @@ public:
     template<typename T>
     GenericDatum(const NodePtr &schema, const T &v) : type_(schema->type()), logicalType_(schema->logicalType()) {
         init(schema);
-#if __cplusplus >= 201703L
-        *std::any_cast<T>(&value_) = v;
-#else
-        *boost::any_cast<T>(&value_) = v;
-#endif
+        *valuePtr(static_cast<T *>(nullptr)) = v;
     }
 
     /**
@@ -263,6 +376,17 @@ public:
         }
     }
 
+    /**
+     * Selects a new branch, whose value is swapped with \p datum. The
+     * datum must correspond to the schema of the branch.
+     * \param branch The index for the selected branch.
+     * \param datum The new value, which receives the previous one.
+     */
+    void selectBranch(size_t branch, GenericDatum &datum) {
+        std::swap(datum_, datum);
+        curBranch_ = branch;
+    }
+
     /**
      * Returns the datum corresponding to the currently selected branch
      * in this union.
@@ -359,6 +483,42 @@ public:
     }
 };
 
+/**
+ * A path to a field of nested records, such as "a.b.c", resolved once
+ * against a record schema into field positions. Looking the field up
+ * through the path then involves no name comparisons.
+ */
+class AVRO_DECL GenericFieldPath {
+    std::vector<size_t> indices_;
+
+public:
+    /**
+     * Resolves the dot separated \p path against \p schema, which should
+     * be of Avro type record. All but the last name in the path must refer
+     * to fields that are records themselves.
+     */
+    GenericFieldPath(const NodePtr &schema, const std::string &path);
+
+    /**
+     * Returns the positions of the fields along the path.
+     */
+    const std::vector<size_t> &indices() const {
+        return indices_;
+    }
+
+    /**
+     * Returns the field of \p record this path leads to. The record must
+     * be of the schema the path was resolved against.
+     */
+    const GenericDatum &get(const GenericRecord &record) const;
+
+    /**
+     * Returns the reference to the field of \p record this path leads to,
+     * which can be used to change the contents.
+     */
+    GenericDatum &get(GenericRecord &record) const;
+};
+
 /**
  * The generic container for Avro arrays.
  */
@@ -419,14 +579,63 @@ public:
     }
 
     /**
-     * Returns the reference to the contents of this map.
+     * Returns the reference to the contents of this map. Since the contents
+     * may be changed through it, the index used by find() is dropped.
      */
     Value &value() {
+        invalidate();
         return value_;
     }
 
+    /**
+     * Returns the entry with the given \p key, or the end of value() if
+     * there is none. If several entries have the key, the first one is
+     * returned. Large maps are searched through the hash index if it is
+     * up to date, and scanned otherwise. The index is never built here,
+     * so const lookups may be made from several threads at once.
+     */
+    Value::const_iterator find(const std::string &key) const;
+
+    /**
+     * Returns the entry with the given \p key, or the end of value() if
+     * there is none. Large maps get their hash index built first, and
+     * kept until the contents change. The key of the entry must not be
+     * changed through the returned iterator.
+     */
+    Value::iterator find(const std::string &key) {
+        buildIndex();
+        return value_.begin() + (static_cast<const GenericMap &>(*this).find(key) - value_.cbegin());
+    }
+
+    /**
+     * Builds the hash index used by find() if the map is large and the
+     * index is not up to date. Build it before sharing a map among
+     * threads that only make const lookups.
+     */
+    void buildIndex();
+
+    /**
+     * Returns true if and only if an entry with the given \p key exists.
+     */
+    bool contains(const std::string &key) const {
+        return find(key) != value_.end();
+    }
+
+    /**
+     * Drops the index used by find(). This is needed only if keys are
+     * changed through a reference to the contents obtained before the
+     * index was built.
+     */
+    void invalidate() {
+        index_.clear();
+    }
+
 private:
     Value value_;
+    // Open addressing table over value_, zero for a free slot and
+    // otherwise one more than the position of the entry.
+    std::vector<size_t> index_;
+    size_t indexedSize_ = 0;
 };
 
 /**
@@ -556,26 +765,14 @@ inline LogicalType GenericDatum::logicalType() const {
 
 template<typename T>
 T &GenericDatum::value() {
-    return (type_ == AVRO_UNION) ?
-#if __cplusplus >= 201703L
-                                 std::any_cast<GenericUnion>(&value_)->datum().value<T>()
-                                 : *std::any_cast<T>(&value_);
-#else
-                                 boost::any_cast<GenericUnion>(&value_)->datum().value<T>()
-                                 : *boost::any_cast<T>(&value_);
-#endif
+    return (type_ == AVRO_UNION) ? valuePtr(static_cast<GenericUnion *>(nullptr))->datum().value<T>()
+                                 : *valuePtr(static_cast<T *>(nullptr));
 }
 
 template<typename T>
 const T &GenericDatum::value() const {
-    return (type_ == AVRO_UNION) ?
-#if __cplusplus >= 201703L
-                                 std::any_cast<GenericUnion>(&value_)->datum().value<T>()
-                                 : *std::any_cast<T>(&value_);
-#else
-                                 boost::any_cast<GenericUnion>(&value_)->datum().value<T>()
-                                 : *boost::any_cast<T>(&value_);
-#endif
+    return (type_ == AVRO_UNION) ? valuePtr(static_cast<GenericUnion *>(nullptr))->datum().value<T>()
+                                 : *valuePtr(static_cast<T *>(nullptr));
 }
 
 inline size_t GenericDatum::unionBranch() const {
@@ -586,6 +783,14 @@ inline size_t GenericDatum::unionBranch() const {
 #endif
 }
 
+inline const NodePtr &GenericDatum::unionSchema() const {
+#if __cplusplus >= 201703L
+    return std::any_cast<GenericUnion>(&value_)->schema();
+#else
+    return boost::any_cast<GenericUnion>(&value_)->schema();
+#endif
+}
+
 inline void GenericDatum::selectBranch(size_t branch) {
 #if __cplusplus >= 201703L
     std::any_cast<GenericUnion>(&value_)->selectBranch(branch);
@@ -594,5 +799,13 @@ inline void GenericDatum::selectBranch(size_t branch) {
 #endif
 }
 
+inline void GenericDatum::selectBranch(size_t branch, GenericDatum &value) {
+#if __cplusplus >= 201703L
+    std::any_cast<GenericUnion>(&value_)->selectBranch(branch, value);
+#else
+    boost::any_cast<GenericUnion>(&value_)->selectBranch(branch, value);
+#endif
+}
+
 } // namespace avro
 #endif // avro_GenericDatum_hh__
@@ -72,6 +72,13 @@ inline std::ostream &operator<<(std::ostream &os, const Name &n) {
     return os << n.fullname();
 }
 
+/// The part a record field plays in sorting, given by its "order" attribute.
+enum FieldOrder {
+    ORDER_ASCENDING,
+    ORDER_DESCENDING,
+    ORDER_IGNORE
+};
+
 /// Node is the building block for parse trees.  Each node represents an avro
 /// type.  Compound types have leaf nodes that represent the types they are
 /// composed of.
@@ -137,6 +144,9 @@ public:
     virtual const GenericDatum &defaultValueAt(size_t index) {
         throw Exception(boost::format("No default value at: %1%") % index);
     }
+    virtual FieldOrder fieldOrderAt(size_t index) const {
+        throw Exception(boost::format("No field order at: %1%") % index);
+    }
 
     void addName(const std::string &name) {
         checkLock();
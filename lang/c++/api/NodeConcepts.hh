@@ -22,7 +22,8 @@
 #include "Config.hh"
 
 #include "Exception.hh"
-#include <map>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 namespace avro {
@@ -168,31 +169,79 @@ struct NameIndexConcept {
     }
 };
 
+/// Maps names to their positions through an open addressing hash table
+/// with linear probing, kept at most half full.
 template<>
 struct NameIndexConcept<MultiAttribute<std::string>> {
-    using IndexMap = std::map<std::string, size_t>;
 
     bool lookup(const std::string &name, size_t &index) const {
-        auto iter = map_.find(name);
-        if (iter == map_.end()) {
+        if (slots_.empty()) {
             return false;
         }
-        index = iter->second;
-        return true;
+        const uint64_t h = hash(name);
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            const uint32_t slot = slots_[i];
+            if (slot == 0) {
+                return false;
+            }
+            const Entry &e = entries_[slot - 1];
+            if (e.hash == h && e.name == name) {
+                index = e.index;
+                return true;
+            }
+        }
     }
 
     bool add(const ::std::string &name, size_t index) {
-        bool added = false;
-        auto lb = map_.lower_bound(name);
-        if (lb == map_.end() || map_.key_comp()(name, lb->first)) {
-            map_.insert(lb, IndexMap::value_type(name, index));
-            added = true;
+        size_t existing = 0;
+        if (lookup(name, existing)) {
+            return false;
+        }
+        if (2 * (entries_.size() + 1) > slots_.size()) {
+            rehash(slots_.empty() ? 8 : 2 * slots_.size());
         }
-        return added;
+        entries_.push_back(Entry{hash(name), name, index});
+        insert(entries_.size() - 1);
+        return true;
     }
 
 private:
-    IndexMap map_;
+    struct Entry {
+        uint64_t hash;
+        std::string name;
+        size_t index;
+    };
+
+    // FNV-1a
+    static uint64_t hash(const std::string &name) {
+        uint64_t h = 14695981039346656037ULL;
+        for (char c : name) {
+            h = (h ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+        }
+        return h;
+    }
+
+    void insert(size_t entry) {
+        const size_t mask = slots_.size() - 1;
+        size_t i = entries_[entry].hash & mask;
+        while (slots_[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        slots_[i] = static_cast<uint32_t>(entry + 1);
+    }
+
+    void rehash(size_t size) {
+        slots_.assign(size, 0);
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            insert(i);
+        }
+    }
+
+    std::vector<Entry> entries_;
+    // Zero for a free slot, otherwise one more than the position of the
+    // entry in entries_.
+    std::vector<uint32_t> slots_;
 };
 
 } // namespace concepts
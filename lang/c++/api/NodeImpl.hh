@@ -280,17 +280,21 @@ protected:
 
 class AVRO_DECL NodeRecord : public NodeImplRecord {
     std::vector<GenericDatum> defaultValues;
+    std::vector<FieldOrder> fieldOrders;
 
 public:
     NodeRecord() : NodeImplRecord(AVRO_RECORD) {}
     NodeRecord(const HasName &name, const MultiLeaves &fields,
                const LeafNames &fieldsNames,
-               std::vector<GenericDatum> dv);
+               std::vector<GenericDatum> dv,
+               std::vector<FieldOrder> fo = std::vector<FieldOrder>());
 
     NodeRecord(const HasName &name, const HasDoc &doc, const MultiLeaves &fields,
                const LeafNames &fieldsNames,
-               std::vector<GenericDatum> dv) : NodeImplRecord(AVRO_RECORD, name, doc, fields, fieldsNames, NoSize()),
-                                               defaultValues(std::move(dv)) {
+               std::vector<GenericDatum> dv,
+               std::vector<FieldOrder> fo = std::vector<FieldOrder>()) : NodeImplRecord(AVRO_RECORD, name, doc, fields, fieldsNames, NoSize()),
+                                                                         defaultValues(std::move(dv)),
+                                                                         fieldOrders(std::move(fo)) {
         for (size_t i = 0; i < leafNameAttributes_.size(); ++i) {
             if (!nameIndex_.add(leafNameAttributes_.get(i), i)) {
                 throw Exception(boost::format(
@@ -303,6 +307,7 @@ public:
     void swap(NodeRecord &r) {
         NodeImplRecord::swap(r);
         defaultValues.swap(r.defaultValues);
+        fieldOrders.swap(r.fieldOrders);
     }
 
     SchemaResolution resolve(const Node &reader) const override;
@@ -317,6 +322,10 @@ public:
         return defaultValues[index];
     }
 
+    FieldOrder fieldOrderAt(size_t index) const override {
+        return index < fieldOrders.size() ? fieldOrders[index] : ORDER_ASCENDING;
+    }
+
     void printDefaultToJson(const GenericDatum &g, std::ostream &os, size_t depth) const override;
 };
 
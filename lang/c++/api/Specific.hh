@@ -21,8 +21,13 @@
 
 #include "array"
 #include <algorithm>
+#include <functional>
 #include <map>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "boost/blank.hpp"
@@ -41,7 +46,8 @@
  * double, std::string and std::vector<uint8_t> respectively. In addition,
  * std::vector<T> for arbitrary type T gets encoded as an Avro array of T.
  * Similarly, std::map<std::string, T> for arbitrary type T gets encoded
- * as an Avro map with value type T.
+ * as an Avro map with value type T, as do std::unordered_map<std::string, T>
+ * and std::vector<std::pair<std::string, T> >.
  *
  * Users can have their custom types encoded/decoded by specializing
  * avro::codec_traits class for their types.
@@ -54,6 +60,8 @@ template<typename T>
 void encode(Encoder &e, const T &t);
 template<typename T>
 void decode(Decoder &d, T &t);
+template<typename T>
+size_t encodedSize(const T &t);
 
 /**
  * Codec_traits tells avro how to encode and decode an object of given type.
@@ -61,11 +69,26 @@ void decode(Decoder &d, T &t);
  * The class is expected to have two static methods:
  * \li static void encode(Encoder& e, const T& value);
  * \li static void decode(Decoder& e, T& value);
+ * It may also have
+ * \li static size_t encodedSize(const T& value);
+ * returning the length of the binary encoding of the value.
  * The default is empty.
  */
 template<typename T>
 struct codec_traits;
 
+/**
+ * Returns the length of the zig-zag varint binary encoding of \p l.
+ */
+inline size_t encodedLongSize(int64_t l) {
+    uint64_t n = (static_cast<uint64_t>(l) << 1) ^ static_cast<uint64_t>(l >> 63);
+    size_t r = 1;
+    for (; n >= 0x80; n >>= 7) {
+        ++r;
+    }
+    return r;
+}
+
 /**
  * codec_traits for Avro boolean.
  */
@@ -84,6 +107,13 @@ struct codec_traits<bool> {
     static void decode(Decoder &d, bool &b) {
         b = d.decodeBool();
     }
+
+    /**
+     * Returns the length of the binary encoding of a given value.
+     */
+    static size_t encodedSize(bool) {
+        return 1;
+    }
 };
 
 /**
@@ -104,6 +134,13 @@ struct codec_traits<int32_t> {
     static void decode(Decoder &d, int32_t &i) {
         i = d.decodeInt();
     }
+
+    /**
+     * Returns the length of the binary encoding of a given value.
+     */
+    static size_t encodedSize(int32_t i) {
+        return encodedLongSize(i);
+    }
 };
 
 /**
@@ -124,6 +161,13 @@ struct codec_traits<int64_t> {
     static void decode(Decoder &d, int64_t &l) {
         l = d.decodeLong();
     }
+
+    /**
+     * Returns the length of the binary encoding of a given value.
+     */
+    static size_t encodedSize(int64_t l) {
+        return encodedLongSize(l);
+    }
 };
 
 /**
@@ -144,6 +188,13 @@ struct codec_traits<float> {
     static void decode(Decoder &d, float &f) {
         f = d.decodeFloat();
     }
+
+    /**
+     * Returns the length of the binary encoding of a given value.
+     */
+    static size_t encodedSize(float) {
+        return 4;
+    }
 };
 
 /**
@@ -164,6 +215,13 @@ struct codec_traits<double> {
     static void decode(Decoder &d, double &dbl) {
         dbl = d.decodeDouble();
     }
+
+    /**
+     * Returns the length of the binary encoding of a given value.
+     */
+    static size_t encodedSize(double) {
+        return 8;
+    }
 };
 
 /**
@@ -182,7 +240,14 @@ struct codec_traits<std::string> {
      * Decodes into a given value.
      */
     static void decode(Decoder &d, std::string &s) {
-        s = d.decodeString();
+        d.decodeString(s);
+    }
+
+    /**
+     * Returns the length of the binary encoding of a given value.
+     */
+    static size_t encodedSize(const std::string &s) {
+        return encodedLongSize(static_cast<int64_t>(s.size())) + s.size();
     }
 };
 
@@ -204,6 +269,77 @@ struct codec_traits<std::vector<uint8_t>> {
     static void decode(Decoder &d, std::vector<uint8_t> &s) {
         d.decodeBytes(s);
     }
+
+    /**
+     * Returns the length of the binary encoding of a given value.
+     */
+    static size_t encodedSize(const std::vector<uint8_t> &b) {
+        return encodedLongSize(static_cast<int64_t>(b.size())) + b.size();
+    }
+};
+
+/**
+ * codec_traits for Avro string held in strings with other allocators,
+ * such as std::pmr::string. They are encoded as they are, but decoded
+ * through a per-thread std::string.
+ */
+template<typename Tr, typename A>
+struct codec_traits<std::basic_string<char, Tr, A>> {
+    /**
+     * Encodes a given value.
+     */
+    static void encode(Encoder &e, const std::basic_string<char, Tr, A> &s) {
+        e.encodeString(s.data(), s.size());
+    }
+
+    /**
+     * Decodes into a given value.
+     */
+    static void decode(Decoder &d, std::basic_string<char, Tr, A> &s) {
+        // Decoder only decodes into std::string, so the copy is unavoidable
+        // without a Decoder that can write into caller-supplied storage.
+        static thread_local std::string buf;
+        d.decodeString(buf);
+        s.assign(buf.data(), buf.size());
+    }
+
+    /**
+     * Returns the length of the binary encoding of a given value.
+     */
+    static size_t encodedSize(const std::basic_string<char, Tr, A> &s) {
+        return encodedLongSize(static_cast<int64_t>(s.size())) + s.size();
+    }
+};
+
+/**
+ * codec_traits for Avro bytes held in vectors with other allocators,
+ * such as std::pmr::vector<uint8_t>.
+ */
+template<typename A>
+struct codec_traits<std::vector<uint8_t, A>> {
+    /**
+     * Encodes a given value.
+     */
+    static void encode(Encoder &e, const std::vector<uint8_t, A> &b) {
+        uint8_t empty = 0;
+        e.encodeBytes(b.empty() ? &empty : b.data(), b.size());
+    }
+
+    /**
+     * Decodes into a given value.
+     */
+    static void decode(Decoder &d, std::vector<uint8_t, A> &s) {
+        static thread_local std::vector<uint8_t> buf;
+        d.decodeBytes(buf);
+        s.assign(buf.begin(), buf.end());
+    }
+
+    /**
+     * Returns the length of the binary encoding of a given value.
+     */
+    static size_t encodedSize(const std::vector<uint8_t, A> &b) {
+        return encodedLongSize(static_cast<int64_t>(b.size())) + b.size();
+    }
 };
 
 /**
@@ -226,21 +362,29 @@ struct codec_traits<std::array<uint8_t, N>> {
         d.decodeFixed(N, v);
         std::copy(v.data(), v.data() + N, s.data());
     }
+
+    /**
+     * Returns the length of the binary encoding of a given value.
+     */
+    static size_t encodedSize(const std::array<uint8_t, N> &) {
+        return N;
+    }
 };
 
 /**
- * codec_traits for Avro arrays.
+ * The codec for Avro arrays, shared by the sequence containers that may
+ * hold them. V needs size(), resize(), max_size() and operator[].
  */
-template<typename T>
-struct codec_traits<std::vector<T>> {
+template<typename V>
+struct array_codec_traits {
     /**
      * Encodes a given value.
      */
-    static void encode(Encoder &e, const std::vector<T> &b) {
+    static void encode(Encoder &e, const V &b) {
         e.arrayStart();
         if (!b.empty()) {
             e.setItemCount(b.size());
-            for (typename std::vector<T>::const_iterator it = b.begin();
+            for (typename V::const_iterator it = b.begin();
                  it != b.end(); ++it) {
                 e.startItem();
                 avro::encode(e, *it);
@@ -250,20 +394,63 @@ struct codec_traits<std::vector<T>> {
     }
 
     /**
-     * Decodes into a given value.
+     * Decodes into a given value. The elements already present are
+     * decoded in place so that the storage they hold is reused; new
+     * ones are constructed only past the old size.
      */
-    static void decode(Decoder &d, std::vector<T> &s) {
-        s.clear();
+    static void decode(Decoder &d, V &s) {
+        size_t c = 0;
         for (size_t n = d.arrayStart(); n != 0; n = d.arrayNext()) {
-            for (size_t i = 0; i < n; ++i) {
-                T t;
-                avro::decode(d, t);
-                s.push_back(std::move(t));
+            if (n > s.max_size() - c) {
+                throw Exception("Too many items for array");
+            }
+            if (s.size() < c + n) {
+                s.resize(c + n);
+            }
+            for (size_t i = 0; i < n; ++i, ++c) {
+                decodeItem(d, s[c]);
+            }
+        }
+        s.resize(c);
+    }
+
+    /**
+     * Returns the length of the binary encoding of a given value,
+     * written as a single block.
+     */
+    static size_t encodedSize(const V &b) {
+        size_t r = 1;
+        if (!b.empty()) {
+            r += encodedLongSize(static_cast<int64_t>(b.size()));
+            for (typename V::const_iterator it = b.begin();
+                 it != b.end(); ++it) {
+                r += avro::encodedSize(*it);
             }
         }
+        return r;
+    }
+
+private:
+    static void decodeItem(Decoder &d, typename V::value_type &t) {
+        avro::decode(d, t);
+    }
+
+    static void decodeItem(Decoder &d, std::vector<bool>::reference t) {
+        bool b;
+        avro::decode(d, b);
+        t = b;
     }
 };
 
+/**
+ * codec_traits for Avro arrays. Vectors with any allocator are supported;
+ * with a scoped one such as std::pmr::polymorphic_allocator new elements
+ * allocate from the vector's resource.
+ */
+template<typename T, typename A>
+struct codec_traits<std::vector<T, A>> : array_codec_traits<std::vector<T, A>> {
+};
+
 typedef codec_traits<std::vector<bool>::const_reference> bool_codec_traits;
 
 template<>
@@ -275,21 +462,41 @@ struct codec_traits<std::conditional<avro::is_not_defined<bool_codec_traits>::va
     static void encode(Encoder &e, std::vector<bool>::const_reference b) {
         e.encodeBool(b);
     }
+
+    /**
+     * Returns the length of the binary encoding of a given value.
+     */
+    static size_t encodedSize(std::vector<bool>::const_reference) {
+        return 1;
+    }
 };
 
 /**
- * codec_traits for Avro maps.
+ * Decodes the values of map entries with avro::decode().
  */
-template<typename T>
-struct codec_traits<std::map<std::string, T>> {
+struct value_decoder {
+    template<typename T>
+    void operator()(Decoder &d, T &t) const {
+        avro::decode(d, t);
+    }
+};
+
+/**
+ * The codec for Avro maps, shared by the associative containers that may
+ * hold them. Their keys may be strings with any allocator.
+ */
+template<typename Map>
+struct map_codec_traits {
+    typedef typename Map::key_type Key;
+
     /**
      * Encodes a given value.
      */
-    static void encode(Encoder &e, const std::map<std::string, T> &b) {
+    static void encode(Encoder &e, const Map &b) {
         e.mapStart();
         if (!b.empty()) {
             e.setItemCount(b.size());
-            for (typename std::map<std::string, T>::const_iterator
+            for (typename Map::const_iterator
                      it = b.begin();
                  it != b.end(); ++it) {
                 e.startItem();
@@ -300,19 +507,195 @@ struct codec_traits<std::map<std::string, T>> {
         e.mapEnd();
     }
 
+    /**
+     * Decodes into a given value. The values of keys already present
+     * are decoded in place so that the storage they hold is reused.
+     */
+    static void decode(Decoder &d, Map &s) {
+        decode(d, s, value_decoder());
+    }
+
+    /**
+     * Decodes into a given value like decode(d, s), decoding the value of
+     * each entry with \p decodeValue, which is called with the decoder
+     * and the value.
+     */
+    template<typename F>
+    static void decode(Decoder &d, Map &s, F decodeValue) {
+        typedef typename Map::value_type *Entry;
+        // The entries decoded are noted so that the ones absent from the
+        // input can be dropped afterwards. The list is shared with nested
+        // calls, which use the part past our own entries. Unlike
+        // iterators, pointers to entries survive rehashing. The keys are
+        // decoded into a plain std::string: a cached Key would keep the
+        // memory resource that was in use when it was first allocated.
+        static thread_local std::vector<Entry> seen;
+        static thread_local std::string buf;
+        const size_t base = seen.size();
+        try {
+            bool reused = false;
+            for (size_t n = d.mapStart(); n != 0; n = d.mapNext()) {
+                for (size_t i = 0; i < n; ++i) {
+                    d.decodeString(buf);
+                    const Key &key = keyOf(buf, s);
+                    typename Map::iterator it = s.find(key);
+                    if (it == s.end()) {
+                        it = s.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                                       std::forward_as_tuple())
+                                 .first;
+                    } else {
+                        reused = true;
+                    }
+                    seen.push_back(&*it);
+                    decodeValue(d, it->second);
+                }
+            }
+            // A key repeated in the input is noted more than once, so the
+            // entries are only counted once they are made distinct.
+            typename std::vector<Entry>::iterator end = seen.end();
+            if (reused) {
+                std::sort(seen.begin() + base, end, std::less<Entry>());
+                end = std::unique(seen.begin() + base, end);
+            }
+            if (static_cast<size_t>(end - seen.begin()) - base != s.size()) {
+                Map m = emptyLike(s);
+                for (typename std::vector<Entry>::iterator i = seen.begin() + base; i != end; ++i) {
+                    m.emplace((*i)->first, std::move((*i)->second));
+                }
+                s.swap(m);
+            }
+        } catch (...) {
+            seen.resize(base);
+            throw;
+        }
+        seen.resize(base);
+    }
+
+    /**
+     * Returns the length of the binary encoding of a given value,
+     * written as a single block.
+     */
+    static size_t encodedSize(const Map &b) {
+        size_t r = 1;
+        if (!b.empty()) {
+            r += encodedLongSize(static_cast<int64_t>(b.size()));
+            for (typename Map::const_iterator
+                     it = b.begin();
+                 it != b.end(); ++it) {
+                r += avro::encodedSize(it->first) + avro::encodedSize(it->second);
+            }
+        }
+        return r;
+    }
+
+private:
+    template<typename K = Key>
+    static typename std::enable_if<std::is_same<K, std::string>::value, const K &>::type
+    keyOf(const std::string &buf, const Map &) {
+        return buf;
+    }
+
+    /// Keys with other allocators are made with the map's allocator.
+    template<typename K = Key>
+    static typename std::enable_if<!std::is_same<K, std::string>::value, K>::type
+    keyOf(const std::string &buf, const Map &s) {
+        return K(buf.data(), buf.size(), typename K::allocator_type(s.get_allocator()));
+    }
+
+    template<typename K, typename T, typename C, typename A>
+    static Map emptyLike(const std::map<K, T, C, A> &s) {
+        return Map(s.key_comp(), s.get_allocator());
+    }
+
+    template<typename K, typename T, typename H, typename E, typename A>
+    static Map emptyLike(const std::unordered_map<K, T, H, E, A> &s) {
+        return Map(s.bucket_count(), s.hash_function(), s.key_eq(), s.get_allocator());
+    }
+};
+
+/**
+ * codec_traits for Avro maps. Maps with any comparator and allocator
+ * are supported.
+ */
+template<typename Tr, typename SA, typename T, typename C, typename A>
+struct codec_traits<std::map<std::basic_string<char, Tr, SA>, T, C, A>>
+    : map_codec_traits<std::map<std::basic_string<char, Tr, SA>, T, C, A>> {
+};
+
+/**
+ * codec_traits for Avro maps held in unordered maps, which spare the
+ * decoder the ordered inserts. Avro map entries have no order anyway.
+ */
+template<typename Tr, typename SA, typename T, typename H, typename E, typename A>
+struct codec_traits<std::unordered_map<std::basic_string<char, Tr, SA>, T, H, E, A>>
+    : map_codec_traits<std::unordered_map<std::basic_string<char, Tr, SA>, T, H, E, A>> {
+};
+
+/**
+ * codec_traits for Avro maps held flat, as a vector of key-value pairs in
+ * the order of the encoding. Decoding reuses the pairs already present
+ * and does not look for duplicate keys, which the encoding is not
+ * expected to have.
+ */
+template<typename Tr, typename SA, typename T, typename A>
+struct codec_traits<std::vector<std::pair<std::basic_string<char, Tr, SA>, T>, A>> {
+    typedef std::vector<std::pair<std::basic_string<char, Tr, SA>, T>, A> Map;
+
+    /**
+     * Encodes a given value.
+     */
+    static void encode(Encoder &e, const Map &b) {
+        e.mapStart();
+        if (!b.empty()) {
+            e.setItemCount(b.size());
+            for (typename Map::const_iterator it = b.begin(); it != b.end(); ++it) {
+                e.startItem();
+                avro::encode(e, it->first);
+                avro::encode(e, it->second);
+            }
+        }
+        e.mapEnd();
+    }
+
     /**
      * Decodes into a given value.
      */
-    static void decode(Decoder &d, std::map<std::string, T> &s) {
-        s.clear();
+    static void decode(Decoder &d, Map &s) {
+        decode(d, s, value_decoder());
+    }
+
+    /**
+     * Decodes into a given value, decoding the value of each entry with
+     * \p decodeValue, which is called with the decoder and the value.
+     */
+    template<typename F>
+    static void decode(Decoder &d, Map &s, F decodeValue) {
+        size_t c = 0;
         for (size_t n = d.mapStart(); n != 0; n = d.mapNext()) {
-            for (size_t i = 0; i < n; ++i) {
-                std::string k;
-                avro::decode(d, k);
-                T &t = s[std::move(k)];
-                avro::decode(d, t);
+            if (s.size() < c + n) {
+                s.resize(c + n);
+            }
+            for (size_t i = 0; i < n; ++i, ++c) {
+                avro::decode(d, s[c].first);
+                decodeValue(d, s[c].second);
+            }
+        }
+        s.resize(c);
+    }
+
+    /**
+     * Returns the length of the binary encoding of a given value,
+     * written as a single block.
+     */
+    static size_t encodedSize(const Map &b) {
+        size_t r = 1;
+        if (!b.empty()) {
+            r += encodedLongSize(static_cast<int64_t>(b.size()));
+            for (typename Map::const_iterator it = b.begin(); it != b.end(); ++it) {
+                r += avro::encodedSize(it->first) + avro::encodedSize(it->second);
             }
         }
+        return r;
     }
 };
 
@@ -334,6 +717,13 @@ struct codec_traits<avro::null> {
     static void decode(Decoder &d, avro::null &) {
         d.decodeNull();
     }
+
+    /**
+    * Returns the length of the binary encoding of a given value.
+    */
+    static size_t encodedSize(const avro::null &) {
+        return 0;
+    }
 };
 
 /**
@@ -352,6 +742,52 @@ void decode(Decoder &d, T &t) {
     codec_traits<T>::decode(d, t);
 }
 
+/**
+ * has_encoded_size<T>::value is true if and only if codec_traits<T>
+ * provides encodedSize().
+ */
+template<typename T>
+struct has_encoded_size {
+    template<typename U>
+    static std::true_type test(decltype(codec_traits<U>::encodedSize(std::declval<const U &>())) *);
+
+    template<typename U>
+    static std::false_type test(...);
+
+    static const bool value = decltype(test<T>(nullptr))::value;
+};
+
+namespace detail {
+
+// encodedSize() for types whose codec_traits provide it, and for others.
+template<typename T>
+size_t encodedSize(const T &t, std::true_type) {
+    return codec_traits<T>::encodedSize(t);
+}
+
+template<typename T>
+size_t encodedSize(const T &t, std::false_type) {
+    std::unique_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    codec_traits<T>::encode(*e, t);
+    e->flush();
+    return static_cast<size_t>(os->byteCount());
+}
+
+} // namespace detail
+
+/**
+ * Returns the length of the binary encoding of \p t, so that a buffer
+ * can be sized before encoding into it. Arrays and maps are assumed to
+ * be written in a single block, as binaryEncoder() does. Types whose
+ * codec_traits do not provide encodedSize() are encoded to find out.
+ */
+template<typename T>
+size_t encodedSize(const T &t) {
+    return detail::encodedSize(t, std::integral_constant<bool, has_encoded_size<T>::value>());
+}
+
 } // namespace avro
 
 #endif // avro_Codec_hh__
@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_SpecificContainers_hh__
+#define avro_SpecificContainers_hh__
+
+#include "boost/container/small_vector.hpp"
+#include "boost/container/static_vector.hpp"
+
+#include "Compare.hh"
+#include "Specific.hh"
+
+/**
+ * codec_traits, comparison and hashing for Avro arrays held in the
+ * Boost.Container vectors that keep their first elements inline. They
+ * suit arrays known to be short: a small_vector moves to the heap when
+ * it outgrows its inline capacity, while decoding more items than a
+ * static_vector's capacity fails.
+ */
+namespace avro {
+
+template<typename T, size_t N, typename... P>
+struct codec_traits<boost::container::small_vector<T, N, P...>>
+    : array_codec_traits<boost::container::small_vector<T, N, P...>> {
+};
+
+template<typename T, size_t N, typename... P>
+struct codec_traits<boost::container::static_vector<T, N, P...>>
+    : array_codec_traits<boost::container::static_vector<T, N, P...>> {
+};
+
+template<typename T, size_t N, typename... P>
+int compare(const boost::container::small_vector<T, N, P...> &a,
+            const boost::container::small_vector<T, N, P...> &b) {
+    return compareArrays(a, b);
+}
+
+template<typename T, size_t N, typename... P>
+int compare(const boost::container::static_vector<T, N, P...> &a,
+            const boost::container::static_vector<T, N, P...> &b) {
+    return compareArrays(a, b);
+}
+
+template<typename T, size_t N, typename... P>
+size_t hashValue(const boost::container::small_vector<T, N, P...> &v) {
+    return hashArray(v);
+}
+
+template<typename T, size_t N, typename... P>
+size_t hashValue(const boost::container::static_vector<T, N, P...> &v) {
+    return hashArray(v);
+}
+
+} // namespace avro
+
+#endif
@@ -22,6 +22,8 @@
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "boost/utility.hpp"
 
@@ -147,11 +149,81 @@ public:
 
 typedef std::unique_ptr<OutputStream> OutputStreamPtr;
 
+/**
+ * A thread-safe pool of fixed-size memory chunks that memory output streams
+ * can share. Chunks released by a stream are kept for reuse, up to the
+ * given number of chunks; any more are freed.
+ */
+class AVRO_DECL MemoryChunkPool : boost::noncopyable {
+    const size_t chunkSize_;
+    const size_t maxChunks_;
+    mutable std::mutex mutex_;
+    std::vector<uint8_t *> free_;
+
+public:
+    /**
+     * Constructs a pool of chunks of size \p chunkSize, which keeps at
+     * most \p maxChunks free chunks.
+     */
+    MemoryChunkPool(size_t chunkSize, size_t maxChunks);
+
+    ~MemoryChunkPool();
+
+    /**
+     * Returns the size of the chunks in this pool.
+     */
+    size_t chunkSize() const { return chunkSize_; }
+
+    /**
+     * Returns a chunk from the pool, allocating a new one if the pool
+     * is empty.
+     */
+    uint8_t *acquire();
+
+    /**
+     * Returns the chunk, which must have been obtained from acquire(),
+     * to the pool.
+     */
+    void release(uint8_t *chunk);
+
+    /**
+     * Returns the number of free chunks currently held by the pool.
+     */
+    size_t pooled() const;
+};
+
+typedef std::shared_ptr<MemoryChunkPool> MemoryChunkPoolPtr;
+
 /**
  * Returns a new OutputStream, which grows in memory chunks of specified size.
  */
 AVRO_DECL OutputStreamPtr memoryOutputStream(size_t chunkSize = 4 * 1024);
 
+/**
+ * Returns a new OutputStream, which grows in memory chunks. The first chunk
+ * is \p chunkSize bytes and each subsequent chunk is twice as large as the
+ * previous one, up to \p maxChunkSize bytes. This keeps the number of chunks
+ * small for large contents.
+ */
+AVRO_DECL OutputStreamPtr memoryOutputStream(size_t chunkSize,
+                                             size_t maxChunkSize);
+
+/**
+ * Returns a new OutputStream, which grows in memory chunks taken from the
+ * given pool. The chunks are returned to the pool when the stream is
+ * destroyed.
+ */
+AVRO_DECL OutputStreamPtr memoryOutputStream(const MemoryChunkPoolPtr &pool);
+
+/**
+ * Discards the contents written into the output stream, which should be a
+ * memory output stream, so that it can be written afresh. The memory chunks
+ * are retained and reused for subsequent writes. Any input stream obtained
+ * from the output stream through memoryInputStream() must not be used
+ * after this call.
+ */
+AVRO_DECL void resetMemoryOutputStream(OutputStream &source);
+
 /**
  * Returns a new InputStream, with the data from the given byte array.
  * It does not copy the data, the byte array should remain valid
@@ -262,6 +334,16 @@ struct StreamReader {
         next_ = end_ = nullptr;
     }
 
+    /**
+     * Returns the number of bytes that can be read without going back to
+     * the underlying stream. When a whole value is known to fit within
+     * this many bytes, it can be decoded directly from next_ without
+     * checking for the end of the data at every byte.
+     */
+    size_t available() const {
+        return end_ - next_;
+    }
+
     /**
      * Read just one byte from the underlying stream. If there are no
      * more data, throws an exception.
@@ -394,6 +476,15 @@ struct StreamWriter {
         next_ = end_;
     }
 
+    /**
+     * Returns the number of bytes that can be written without asking the
+     * underlying stream for more space. When a whole value is known to fit
+     * within this many bytes, it can be encoded directly at next_.
+     */
+    size_t available() const {
+        return end_ - next_;
+    }
+
     /**
      * Writes a single byte.
      */
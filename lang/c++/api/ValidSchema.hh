@@ -22,6 +22,9 @@
 #include "Config.hh"
 #include "Node.hh"
 
+#include <cstdint>
+#include <string>
+
 namespace avro {
 
 class AVRO_DECL Schema;
@@ -54,6 +57,15 @@ public:
 
     void toFlatList(std::ostream &os) const;
 
+    /// Returns the Parsing Canonical Form of this schema as defined by the
+    /// Avro specification: full names, no whitespace and only the
+    /// attributes that affect how data is read.
+    std::string toCanonicalJson() const;
+
+    /// Returns the 64-bit Rabin fingerprint (CRC-64-AVRO) of the
+    /// Parsing Canonical Form of this schema.
+    uint64_t fingerprint() const;
+
 protected:
     NodePtr root_;
 
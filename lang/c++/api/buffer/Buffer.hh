@@ -76,6 +76,13 @@ public:
 
     typedef detail::OutputBufferIterator const_iterator;
 
+    /**
+     * The policy that determines the sizes of the memory blocks backing
+     * the buffer and how they are allocated.
+     **/
+
+    typedef detail::BlockPolicy BlockPolicy;
+
     /**
      * Default constructor.  Will pre-allocate at least the requested size, but
      * can grow larger on demand.
@@ -93,7 +100,20 @@ public:
      *
      **/
 
-    explicit OutputBuffer(size_type reserveSize = 0) : pimpl_(new detail::BufferImpl) {
+    explicit OutputBuffer(size_type reserveSize = 0) : pimpl_(boost::make_shared<detail::BufferImpl>()) {
+        if (reserveSize) {
+            reserve(reserveSize);
+        }
+    }
+
+    /**
+     * Constructs a buffer that sizes and allocates its memory blocks
+     * according to the given policy, for example to grow into larger
+     * blocks for big payloads, or to take blocks from a custom allocator.
+     * The policy is carried over to clones of this buffer.
+     **/
+
+    explicit OutputBuffer(const detail::BlockPolicy &policy, size_type reserveSize = 0) : pimpl_(boost::make_shared<detail::BufferImpl>(policy)) {
         if (reserveSize) {
             reserve(reserveSize);
         }
@@ -258,7 +278,7 @@ public:
      **/
 
     OutputBuffer clone() const {
-        detail::BufferImpl::SharedPtr newImpl(new detail::BufferImpl(*pimpl_));
+        detail::BufferImpl::SharedPtr newImpl(boost::make_shared<detail::BufferImpl>(*pimpl_));
         return OutputBuffer(newImpl);
     }
 
@@ -331,7 +351,7 @@ public:
      * deleting the underlying data if no other copies of exist.
      **/
 
-    InputBuffer() : pimpl_(new detail::BufferImpl) {}
+    InputBuffer() : pimpl_(boost::make_shared<detail::BufferImpl>()) {}
 
     /**
      * Construct an InputBuffer that contains the contents of an OutputBuffer.
@@ -345,7 +365,7 @@ public:
      * Implicit conversion is allowed.
      **/
     // NOLINTNEXTLINE(google-explicit-constructor)
-    InputBuffer(const OutputBuffer &src) : pimpl_(new detail::BufferImpl(*src.pimpl_)) {}
+    InputBuffer(const OutputBuffer &src) : pimpl_(boost::make_shared<detail::BufferImpl>(*src.pimpl_)) {}
 
     /**
      * Does the buffer have any data?
@@ -432,7 +452,7 @@ private:
  */
 
 inline InputBuffer OutputBuffer::extractData() {
-    detail::BufferImpl::SharedPtr newImpl(new detail::BufferImpl);
+    detail::BufferImpl::SharedPtr newImpl(boost::make_shared<detail::BufferImpl>());
     if (pimpl_->size()) {
         pimpl_->extractData(*newImpl);
     }
@@ -444,7 +464,7 @@ inline InputBuffer OutputBuffer::extractData(size_type bytes) {
         throw std::out_of_range("trying to extract more data than exists");
     }
 
-    detail::BufferImpl::SharedPtr newImpl(new detail::BufferImpl);
+    detail::BufferImpl::SharedPtr newImpl(boost::make_shared<detail::BufferImpl>());
     if (bytes > 0) {
         if (bytes < pimpl_->size()) {
             pimpl_->extractData(*newImpl, bytes);
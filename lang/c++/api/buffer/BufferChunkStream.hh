@@ -0,0 +1,199 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_BufferChunkStream_hh__
+#define avro_BufferChunkStream_hh__
+
+#include <algorithm>
+
+#include "../Stream.hh"
+#include "Buffer.hh"
+
+/**
+ * \file BufferChunkStream.hh
+ *
+ * \brief InputStream and OutputStream implementations over buffers
+ *
+ * These let the binary encoder and decoder work with InputBuffer and
+ * OutputBuffer directly.  The streams hand out pointers into the chunks of
+ * the buffers, so no data is copied on the way in or out.
+ **/
+
+namespace avro {
+
+/**
+ * \brief An InputStream that reads the chunks of an InputBuffer in place.
+ *
+ * The stream keeps a (shallow) copy of the buffer, so the data remains
+ * valid for as long as the stream exists.
+ **/
+
+class AVRO_DECL BufferInputStream : public InputStream {
+
+public:
+    /// Constructor, requires an InputBuffer to read from.
+    explicit BufferInputStream(const InputBuffer &buf) : buffer_(buf),
+                                                         iter_(buffer_.begin()),
+                                                         offset_(0),
+                                                         byteCount_(0) {}
+
+    bool next(const uint8_t **data, size_t *len) override {
+        for (; iter_ != buffer_.end(); ++iter_, offset_ = 0) {
+            size_t n = iter_->size() - offset_;
+            if (n > 0) {
+                *data = reinterpret_cast<const uint8_t *>(iter_->data()) + offset_;
+                *len = n;
+                offset_ += n;
+                byteCount_ += n;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void backup(size_t len) override {
+        offset_ -= len;
+        byteCount_ -= len;
+    }
+
+    void skip(size_t len) override {
+        while (len > 0 && iter_ != buffer_.end()) {
+            size_t n = std::min(len, iter_->size() - offset_);
+            offset_ += n;
+            byteCount_ += n;
+            len -= n;
+            if (offset_ == iter_->size()) {
+                ++iter_;
+                offset_ = 0;
+            }
+        }
+    }
+
+    size_t byteCount() const override {
+        return byteCount_;
+    }
+
+private:
+    const InputBuffer buffer_;
+    InputBuffer::const_iterator iter_;
+    size_t offset_; ///< Bytes of the current chunk that have been read
+    size_t byteCount_;
+};
+
+/**
+ * \brief An OutputStream that writes into the free space of an OutputBuffer.
+ *
+ * The space handed out by next() is reserved in the buffer and committed
+ * with OutputBuffer::wroteTo() on the following call to next() or flush().
+ * The buffer only shows the data written once it is committed, so flush
+ * the encoder before extracting the data, for example to send it with
+ * writev through toIovec().  When the stream is destroyed, the last space
+ * handed out is committed only if backup() has settled how much of it was
+ * written; an encoder that was not flushed leaves nothing there.
+ *
+ * The stream shares the buffer with the OutputBuffer it was constructed
+ * with; as with copies of an OutputBuffer, only one of them should be
+ * written to at a time.
+ **/
+
+class AVRO_DECL BufferOutputStream : public OutputStream {
+
+public:
+    /// Constructor, writes to the given buffer, reserving at least
+    /// reserveSize bytes whenever it runs out of free space.
+    explicit BufferOutputStream(const OutputBuffer &buf,
+                                size_t reserveSize = detail::kDefaultBlockSize) : buffer_(buf),
+                                                                                   reserveSize_(reserveSize),
+                                                                                   pending_(0),
+                                                                                   settled_(true),
+                                                                                   byteCount_(0) {}
+
+    ~BufferOutputStream() override {
+        if (settled_) {
+            commit();
+        }
+    }
+
+    bool next(uint8_t **data, size_t *len) override {
+        commit();
+        if (buffer_.freeSpace() == 0) {
+            buffer_.reserve(reserveSize_);
+        }
+        OutputBuffer::const_iterator it = buffer_.begin();
+        *data = reinterpret_cast<uint8_t *>(it->data());
+        *len = it->size();
+        pending_ = it->size();
+        settled_ = false;
+        byteCount_ += pending_;
+        return true;
+    }
+
+    void backup(size_t len) override {
+        pending_ -= len;
+        settled_ = true;
+        byteCount_ -= len;
+    }
+
+    uint64_t byteCount() const override {
+        return byteCount_;
+    }
+
+    void flush() override {
+        commit();
+    }
+
+    /// Returns the buffer this stream writes to.
+    const OutputBuffer &getBuffer() const {
+        return buffer_;
+    }
+
+private:
+    void commit() {
+        if (pending_ != 0) {
+            buffer_.wroteTo(pending_);
+            pending_ = 0;
+        }
+    }
+
+    OutputBuffer buffer_;
+    const size_t reserveSize_;
+    size_t pending_; ///< Bytes handed out by next() and not yet committed
+    bool settled_;   ///< Whether backup() was called since the last next()
+    uint64_t byteCount_;
+};
+
+/**
+ * Returns a new InputStream that reads the contents of the given buffer
+ * without copying it.
+ */
+inline InputStreamPtr bufferInputStream(const InputBuffer &buf) {
+    return InputStreamPtr(new BufferInputStream(buf));
+}
+
+/**
+ * Returns a new OutputStream that writes into the given buffer without
+ * intermediate copies.
+ */
+inline OutputStreamPtr bufferOutputStream(const OutputBuffer &buf,
+                                          size_t reserveSize = detail::kDefaultBlockSize) {
+    return OutputStreamPtr(new BufferOutputStream(buf, reserveSize));
+}
+
+} // namespace avro
+
+#endif
@@ -205,7 +205,7 @@ public:
             // force no copy
             bytes = 0;
         }
-        detail::BufferImpl::SharedPtr newImpl(new detail::BufferImpl);
+        detail::BufferImpl::SharedPtr newImpl(boost::make_shared<detail::BufferImpl>());
         if (bytes) {
             bufferImpl_->copyData(*newImpl, iter_, chunkPos_, bytes);
             doSkip(bytes);
@@ -20,10 +20,13 @@
 #define avro_BufferDetail_hh__
 
 #include <boost/function.hpp>
-#include <boost/shared_array.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/static_assert.hpp>
 #include <boost/utility.hpp>
+#include <algorithm>
+#include <atomic>
+#include <new>
 #include <utility>
 #ifdef HAVE_BOOST_ASIO
 #include <boost/asio/buffer.hpp>
@@ -58,18 +61,195 @@ const size_type kDefaultBlockSize = kMinBlockSize;
 typedef boost::function<void(void)> free_func;
 
 /**
- * Simple class to hold a functor that executes on delete
+ * \brief Interface for supplying the memory blocks that back buffer chunks.
+ *
+ * A buffer normally allocates its blocks with new[].  An allocator can be
+ * supplied through BlockPolicy to obtain them elsewhere, for example from
+ * huge pages or from an arena.  The allocator is held by every block it
+ * allocated, so it stays alive until the last of them is released.
+ **/
+class BlockAllocator {
+public:
+    virtual ~BlockAllocator() = default;
+
+    /// Returns a block of at least size bytes.  Failure is reported by
+    /// throwing; a null result is treated as std::bad_alloc.
+    virtual data_type *allocate(size_type size) = 0;
+
+    /// Releases a block of the given size, previously returned by allocate().
+    virtual void deallocate(data_type *block, size_type size) = 0;
+};
+
+typedef boost::shared_ptr<BlockAllocator> BlockAllocatorPtr;
+
+/**
+ * \brief Controls how a buffer sizes and allocates the blocks behind its
+ * chunks.
+ *
+ * Blocks allocated on demand by writes start at minBlockSize.  When growth
+ * is enabled, each such block is twice the size of the previous one, up to
+ * maxBlockSize, so large payloads end up in a few large chunks.  Explicit
+ * reservations are always split into blocks between minBlockSize and
+ * maxBlockSize.  A minimum below one byte is taken as one, so that every
+ * block adds free space.
+ **/
+struct BlockPolicy {
+    size_type minBlockSize; ///< Smallest block that will be allocated
+    size_type maxBlockSize; ///< Largest block that will be allocated
+    bool grow;              ///< Double the size of successive blocks
+    BlockAllocatorPtr allocator; ///< If null, blocks are allocated by the buffer
+    /// If false, the blocks are reference counted without atomic operations,
+    /// and the buffer, its copies and any buffer sharing its data must only
+    /// be used by one thread.
+    bool threadSafe;
+
+    /// The default policy: fixed blocks of kDefaultBlockSize allocated by the buffer.
+    BlockPolicy() : minBlockSize(kMinBlockSize), maxBlockSize(kMaxBlockSize),
+                    grow(false), threadSafe(true) {}
+
+    BlockPolicy(size_type minSize, size_type maxSize, bool growBlocks,
+                BlockAllocatorPtr blockAllocator = BlockAllocatorPtr(),
+                bool threadSafeBlocks = true) : minBlockSize(minSize == 0 ? 1 : minSize),
+                                                maxBlockSize(maxSize < minBlockSize ? minBlockSize : maxSize),
+                                                grow(growBlocks),
+                                                allocator(std::move(blockAllocator)),
+                                                threadSafe(threadSafeBlocks) {}
+};
+
+/**
+ * \brief The reference counted memory block that backs one or more chunks.
+ *
+ * The reference count is kept in the block itself, so that copying a chunk
+ * costs a single increment and no separate control block is allocated.
+ * Blocks allocated by the buffer hold this header and the data in a single
+ * allocation.
+ *
+ * A block created for a single threaded buffer updates its count with
+ * plain loads and stores instead of atomic read-modify-write operations.
+ * Such a block, and every buffer sharing it, must only be used by one
+ * thread at a time.
+ **/
+class Block : boost::noncopyable {
+public:
+    /// Adds a reference to this block.
+    void addRef() {
+        if (threadSafe_) {
+            refs_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            refs_.store(refs_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    /// Removes a reference to this block, destroying it with the last one.
+    void release() {
+        if (threadSafe_) {
+            if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                destroy();
+            }
+        } else {
+            size_t refs = refs_.load(std::memory_order_relaxed) - 1;
+            refs_.store(refs, std::memory_order_relaxed);
+            if (refs == 0) {
+                destroy();
+            }
+        }
+    }
+
+    /// The first byte of the data in this block.
+    data_type *data() const {
+        return data_;
+    }
+
+protected:
+    Block(data_type *data, bool threadSafe) : refs_(1), threadSafe_(threadSafe), data_(data) {}
+    virtual ~Block() = default;
+
+    /// Frees the block, including this header.
+    virtual void destroy() = 0;
+
+    std::atomic<size_t> refs_;
+    const bool threadSafe_;
+    data_type *const data_;
+};
+
+/**
+ * A block whose header and data are obtained in a single allocation, with
+ * the data immediately following the header.
+ **/
+class HeapBlock : public Block {
+public:
+    static Block *create(size_type size, bool threadSafe) {
+        void *p = ::operator new(sizeof(HeapBlock) + size);
+        return new (p) HeapBlock(reinterpret_cast<data_type *>(p) + sizeof(HeapBlock), threadSafe);
+    }
+
+private:
+    HeapBlock(data_type *data, bool threadSafe) : Block(data, threadSafe) {}
+
+    void destroy() override {
+        this->~HeapBlock();
+        ::operator delete(this);
+    }
+};
+
+/**
+ * A block whose data is obtained from a BlockAllocator, and returned to it
+ * when the block is destroyed.
  **/
-class CallOnDestroy {
+class AllocatorBlock : public Block {
 public:
-    explicit CallOnDestroy(free_func func) : func_(std::move(func)) {}
-    ~CallOnDestroy() {
+    static Block *create(size_type size, const BlockAllocatorPtr &allocator, bool threadSafe) {
+        data_type *data = allocator->allocate(size);
+        if (data == nullptr) {
+            throw std::bad_alloc();
+        }
+        try {
+            return new AllocatorBlock(data, size, allocator, threadSafe);
+        } catch (...) {
+            allocator->deallocate(data, size);
+            throw;
+        }
+    }
+
+private:
+    AllocatorBlock(data_type *data, size_type size, BlockAllocatorPtr allocator, bool threadSafe) : Block(data, threadSafe), size_(size), allocator_(std::move(allocator)) {}
+
+    void destroy() override {
+        allocator_->deallocate(data(), size_);
+        delete this;
+    }
+
+    size_type size_;
+    BlockAllocatorPtr allocator_;
+};
+
+/**
+ * A block wrapping data not owned by the buffer, which calls a functor
+ * when it is no longer referenced.
+ **/
+class ForeignBlock : public Block {
+public:
+    static Block *create(const data_type *data, const free_func &func) {
+        try {
+            return new ForeignBlock(const_cast<data_type *>(data), func);
+        } catch (...) {
+            if (func) {
+                func();
+            }
+            throw;
+        }
+    }
+
+private:
+    ForeignBlock(data_type *data, free_func func) : Block(data, true), func_(std::move(func)) {}
+
+    void destroy() override {
         if (func_) {
             func_();
         }
+        delete this;
     }
 
-private:
     free_func func_;
 };
 
@@ -79,8 +259,8 @@ private:
  * A chunk is backed by a memory block, and internally it maintains information
  * about which area of the block it may use, and the portion of this area that
  * contains valid data.  More than one chunk may share the same underlying
- * block, but the areas should never overlap.  Chunk holds a shared pointer to
- * an array of bytes so that shared blocks are reference counted.
+ * block, but the areas should never overlap.  Chunk holds a reference to
+ * the block so that shared blocks are reference counted.
  *
  * When a chunk is copied, the copy shares the same underlying buffer, but the
  * copy receives its own copies of the start/cursor/end pointers, so each copy
@@ -94,23 +274,63 @@ class Chunk {
 
 public:
     /// Default constructor, allocates a new underlying block for this chunk.
-    explicit Chunk(size_type size) : underlyingBlock_(new data_type[size]),
-                                     readPos_(underlyingBlock_.get()),
-                                     writePos_(readPos_),
-                                     endPos_(readPos_ + size) {}
+    explicit Chunk(size_type size, bool threadSafe = true) : block_(HeapBlock::create(size, threadSafe)),
+                                                             readPos_(block_->data()),
+                                                             writePos_(readPos_),
+                                                             endPos_(readPos_ + size) {}
+
+    /// Allocates a new underlying block for this chunk from the given allocator.
+    Chunk(size_type size, const BlockAllocatorPtr &allocator, bool threadSafe = true) : block_(AllocatorBlock::create(size, allocator, threadSafe)),
+                                                                                        readPos_(block_->data()),
+                                                                                        writePos_(readPos_),
+                                                                                        endPos_(readPos_ + size) {}
 
     /// Foreign buffer constructor, uses the supplied data for this chunk, and
     /// only for reading.
-    Chunk(const data_type *data, size_type size, const free_func &func) : callOnDestroy_(new CallOnDestroy(func)),
-                                                                          readPos_(const_cast<data_type *>(data)),
+    Chunk(const data_type *data, size_type size, const free_func &func) : block_(ForeignBlock::create(data, func)),
+                                                                          readPos_(block_->data()),
                                                                           writePos_(readPos_ + size),
                                                                           endPos_(writePos_) {}
 
-private:
-    // reference counted object will call a functor when it's destroyed
-    boost::shared_ptr<CallOnDestroy> callOnDestroy_;
+    /// Copy constructor, shares the underlying block.
+    Chunk(const Chunk &src) : block_(src.block_),
+                              readPos_(src.readPos_),
+                              writePos_(src.writePos_),
+                              endPos_(src.endPos_) {
+        block_->addRef();
+    }
+
+    /// Move constructor, takes over the reference to the underlying block.
+    Chunk(Chunk &&src) noexcept : block_(src.block_),
+                                  readPos_(src.readPos_),
+                                  writePos_(src.writePos_),
+                                  endPos_(src.endPos_) {
+        src.block_ = nullptr;
+    }
+
+    Chunk &operator=(const Chunk &src) {
+        Chunk(src).swap(*this);
+        return *this;
+    }
+
+    Chunk &operator=(Chunk &&src) noexcept {
+        Chunk(std::move(src)).swap(*this);
+        return *this;
+    }
+
+    ~Chunk() {
+        if (block_ != nullptr) {
+            block_->release();
+        }
+    }
+
+    void swap(Chunk &other) noexcept {
+        std::swap(block_, other.block_);
+        std::swap(readPos_, other.readPos_);
+        std::swap(writePos_, other.writePos_);
+        std::swap(endPos_, other.endPos_);
+    }
 
-public:
     /// Remove readable bytes from the front of the chunk by advancing the
     /// chunk start position.
     void truncateFront(size_type howMuch) {
@@ -160,8 +380,9 @@ private:
     friend bool operator==(const Chunk &lhs, const Chunk &rhs);
     friend bool operator!=(const Chunk &lhs, const Chunk &rhs);
 
-    // more than one buffer can share an underlying block, so use SharedPtr
-    boost::shared_array<data_type> underlyingBlock_;
+    // more than one buffer can share an underlying block, so it is
+    // reference counted
+    Block *block_;
 
     data_type *readPos_;  ///< The first readable byte in the block
     data_type *writePos_; ///< The end of written data and start of free space
@@ -172,14 +393,14 @@ private:
  * Compare underlying buffers and return true if they are equal
  **/
 inline bool operator==(const Chunk &lhs, const Chunk &rhs) {
-    return lhs.underlyingBlock_ == rhs.underlyingBlock_;
+    return lhs.block_ == rhs.block_;
 }
 
 /**
  * Compare underlying buffers and return true if they are unequal
  **/
 inline bool operator!=(const Chunk &lhs, const Chunk &rhs) {
-    return lhs.underlyingBlock_ != rhs.underlyingBlock_;
+    return lhs.block_ != rhs.block_;
 }
 
 /**
@@ -194,20 +415,33 @@ inline bool operator!=(const Chunk &lhs, const Chunk &rhs) {
 class BufferImpl : boost::noncopyable {
 
     /// Add a new chunk to the list of chunks for this buffer, growing the
-    /// buffer by the default block size.
-    void allocChunkChecked(size_type size = kDefaultBlockSize) {
-        writeChunks_.push_back(Chunk(size));
+    /// buffer by the given size.
+    void allocChunkChecked(size_type size) {
+        if (policy_.allocator) {
+            writeChunks_.emplace_back(size, policy_.allocator, policy_.threadSafe);
+        } else {
+            writeChunks_.emplace_back(size, policy_.threadSafe);
+        }
         freeSpace_ += writeChunks_.back().freeSize();
     }
 
+    /// Add a new chunk to the list of chunks for this buffer, growing the
+    /// buffer by the next block size of the policy.
+    void allocChunkChecked() {
+        allocChunkChecked(nextBlockSize_);
+        if (policy_.grow && nextBlockSize_ < policy_.maxBlockSize) {
+            nextBlockSize_ = std::min(nextBlockSize_ * 2, policy_.maxBlockSize);
+        }
+    }
+
     /// Add a new chunk to the list of chunks for this buffer, growing the
     /// buffer by the requested size, but within the range of a minimum and
     /// maximum.
     void allocChunk(size_type size) {
-        if (size < kMinBlockSize) {
-            size = kMinBlockSize;
-        } else if (size > kMaxBlockSize) {
-            size = kMaxBlockSize;
+        if (size < policy_.minBlockSize) {
+            size = policy_.minBlockSize;
+        } else if (size > policy_.maxBlockSize) {
+            size = policy_.maxBlockSize;
         }
         allocChunkChecked(size);
     }
@@ -279,12 +513,27 @@ public:
 
     /// Default constructor, creates a buffer without any chunks
     BufferImpl() : freeSpace_(0),
-                   size_(0) {}
+                   size_(0),
+                   nextBlockSize_(policy_.minBlockSize) {}
+
+    /// Creates a buffer without any chunks, which allocates its blocks
+    /// according to the given policy.
+    explicit BufferImpl(BlockPolicy policy) : freeSpace_(0),
+                                              size_(0),
+                                              policy_(std::move(policy)),
+                                              nextBlockSize_(policy_.minBlockSize) {}
 
     /// Copy constructor, gets a copy of all the chunks with data.
     BufferImpl(const BufferImpl &src) : readChunks_(src.readChunks_),
                                         freeSpace_(0),
-                                        size_(src.size_) {}
+                                        size_(src.size_),
+                                        policy_(src.policy_),
+                                        nextBlockSize_(policy_.minBlockSize) {}
+
+    /// The policy used to allocate blocks for this buffer.
+    const BlockPolicy &policy() const {
+        return policy_;
+    }
 
     /// Amount of data held in this buffer.
     size_type size() const {
@@ -495,7 +744,7 @@ public:
     /// free the data, but it will call the supplied function when the data is
     /// no longer referenced by the buffer (or copies of the buffer).
     void appendForeignData(const data_type *data, size_type size, const free_func &func) {
-        readChunks_.push_back(Chunk(data, size, func));
+        readChunks_.emplace_back(data, size, func);
         size_ += size;
     }
     BufferImpl &operator=(const BufferImpl &src) = delete;
@@ -506,6 +755,9 @@ private:
 
     size_type freeSpace_; ///< capacity of buffer before allocation required
     size_type size_;      ///< amount of data in buffer
+
+    BlockPolicy policy_;      ///< how blocks are sized and allocated
+    size_type nextBlockSize_; ///< size of the next block allocated on demand
 };
 
 } // namespace detail
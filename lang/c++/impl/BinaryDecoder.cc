@@ -25,6 +25,9 @@ namespace avro {
 
 using std::make_shared;
 
+/// The number of bytes in the longest valid encoding of a long.
+static const size_t kMaxVarintLength = 10;
+
 class BinaryDecoder : public Decoder {
     StreamReader in_;
 
@@ -54,6 +57,7 @@ class BinaryDecoder : public Decoder {
     size_t doDecodeItemCount();
     size_t doDecodeLength();
     void drain() final;
+    bool isBinary() const final { return true; }
 };
 
 DecoderPtr binaryDecoder() {
@@ -172,7 +176,7 @@ size_t BinaryDecoder::doDecodeItemCount() {
 }
 
 size_t BinaryDecoder::arrayNext() {
-    return static_cast<size_t>(doDecodeLong());
+    return doDecodeItemCount();
 }
 
 size_t BinaryDecoder::skipArray() {
@@ -204,6 +208,27 @@ size_t BinaryDecoder::decodeUnionIndex() {
 }
 
 int64_t BinaryDecoder::doDecodeLong() {
+    if (in_.available() >= kMaxVarintLength) {
+        // The longest valid varint lies within the current chunk, so decode
+        // it in place without checking for the end of data at every byte.
+        // This is always the case for contiguous memory input, except for
+        // the last few bytes.
+        const uint8_t *p = in_.next_;
+        uint64_t encoded = 0;
+        int shift = 0;
+        uint8_t u;
+        do {
+            if (shift >= 64) {
+                throw Exception("Invalid Avro varint");
+            }
+            u = *p++;
+            encoded |= static_cast<uint64_t>(u & 0x7f) << shift;
+            shift += 7;
+        } while (u & 0x80);
+        in_.next_ = p;
+        return decodeZigzag64(encoded);
+    }
+
     uint64_t encoded = 0;
     int shift = 0;
     uint8_t u;
@@ -19,11 +19,15 @@
 #include "Encoder.hh"
 #include "Zigzag.hh"
 #include <array>
+#include <vector>
 
 namespace avro {
 
 using std::make_shared;
 
+/// The number of bytes in the longest valid encoding of a long.
+static const size_t kMaxVarintLength = 10;
+
 class BinaryEncoder : public Encoder {
     StreamWriter out_;
 
@@ -37,6 +41,7 @@ class BinaryEncoder : public Encoder {
     void encodeFloat(float f) final;
     void encodeDouble(double d) final;
     void encodeString(const std::string &s) final;
+    void encodeString(const char *s, size_t len) final;
     void encodeBytes(const uint8_t *bytes, size_t len) final;
     void encodeFixed(const uint8_t *bytes, size_t len) final;
     void encodeEnum(size_t e) final;
@@ -51,10 +56,77 @@ class BinaryEncoder : public Encoder {
     void doEncodeLong(int64_t l);
 };
 
+/**
+ * A binary encoder that writes each block of an array or map in the sized
+ * form, a negative item count followed by the block's size in bytes, so
+ * that readers can skip the block without decoding it. The block is held
+ * in memory until it is complete. Nested blocks each have their own buffer.
+ * If the buffered bytes go beyond the limit, all pending blocks are written
+ * out in the plain form, with a positive count and no size.
+ */
+class BlockingBinaryEncoder : public Encoder {
+    struct Block {
+        size_t count;
+        bool open;
+        bool buffered;
+        std::vector<uint8_t> data;
+
+        Block() : count(0), open(false), buffered(false) {}
+    };
+
+    StreamWriter out_;
+    const size_t maxBufferSize_;
+    // One entry per array or map being written. The vector only grows,
+    // so that block buffers are reused from one datum to the next.
+    std::vector<Block> blocks_;
+    size_t depth_;
+    size_t buffered_;
+    // Where the bytes go: the innermost buffered block or, if null, out_.
+    std::vector<uint8_t> *target_;
+
+    void init(OutputStream &os) final;
+    void flush() final;
+    int64_t byteCount() const final;
+    void encodeNull() final;
+    void encodeBool(bool b) final;
+    void encodeInt(int32_t i) final;
+    void encodeLong(int64_t l) final;
+    void encodeFloat(float f) final;
+    void encodeDouble(double d) final;
+    void encodeString(const std::string &s) final;
+    void encodeString(const char *s, size_t len) final;
+    void encodeBytes(const uint8_t *bytes, size_t len) final;
+    void encodeFixed(const uint8_t *bytes, size_t len) final;
+    void encodeEnum(size_t e) final;
+    void arrayStart() final;
+    void arrayEnd() final;
+    void mapStart() final;
+    void mapEnd() final;
+    void setItemCount(size_t count) final;
+    void startItem() final;
+    void encodeUnionIndex(size_t e) final;
+
+    void doEncodeLong(std::vector<uint8_t> *target, int64_t l);
+    void doWriteBytes(std::vector<uint8_t> *target, const uint8_t *bytes, size_t len);
+    std::vector<uint8_t> *targetAt(size_t depth);
+    void containerStart();
+    void containerEnd();
+    void closeBlock();
+    void spill();
+
+public:
+    explicit BlockingBinaryEncoder(size_t maxBufferSize) : maxBufferSize_(maxBufferSize), depth_(0),
+                                                           buffered_(0), target_(nullptr) {}
+};
+
 EncoderPtr binaryEncoder() {
     return make_shared<BinaryEncoder>();
 }
 
+EncoderPtr blockingBinaryEncoder(size_t maxBufferSize) {
+    return make_shared<BlockingBinaryEncoder>(maxBufferSize);
+}
+
 void BinaryEncoder::init(OutputStream &os) {
     out_.reset(os);
 }
@@ -89,8 +161,12 @@ void BinaryEncoder::encodeDouble(double d) {
 }
 
 void BinaryEncoder::encodeString(const std::string &s) {
-    doEncodeLong(s.size());
-    out_.writeBytes(reinterpret_cast<const uint8_t *>(s.c_str()), s.size());
+    encodeString(s.data(), s.size());
+}
+
+void BinaryEncoder::encodeString(const char *s, size_t len) {
+    doEncodeLong(len);
+    out_.writeBytes(reinterpret_cast<const uint8_t *>(s), len);
 }
 
 void BinaryEncoder::encodeBytes(const uint8_t *bytes, size_t len) {
@@ -139,9 +215,211 @@ int64_t BinaryEncoder::byteCount() const {
 }
 
 void BinaryEncoder::doEncodeLong(int64_t l) {
+    if (out_.available() >= kMaxVarintLength) {
+        // There is room for the longest possible varint in the current
+        // chunk, so write it in place instead of staging it.
+        uint64_t v = encodeZigzag64(l);
+        uint8_t *p = out_.next_;
+        while (v >= 0x80) {
+            *p++ = static_cast<uint8_t>(v | 0x80);
+            v >>= 7;
+        }
+        *p++ = static_cast<uint8_t>(v);
+        out_.next_ = p;
+        return;
+    }
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
     std::array<uint8_t, 10> bytes;
     auto size = encodeInt64(l, bytes);
     out_.writeBytes(bytes.data(), size);
 }
+
+void BlockingBinaryEncoder::init(OutputStream &os) {
+    out_.reset(os);
+    for (Block &b : blocks_) {
+        b.open = false;
+        b.data.clear();
+    }
+    depth_ = 0;
+    buffered_ = 0;
+    target_ = nullptr;
+}
+
+void BlockingBinaryEncoder::flush() {
+    out_.flush();
+}
+
+int64_t BlockingBinaryEncoder::byteCount() const {
+    return out_.byteCount();
+}
+
+void BlockingBinaryEncoder::encodeNull() {
+}
+
+void BlockingBinaryEncoder::encodeBool(bool b) {
+    const uint8_t v = b ? 1 : 0;
+    doWriteBytes(target_, &v, 1);
+}
+
+void BlockingBinaryEncoder::encodeInt(int32_t i) {
+    doEncodeLong(target_, i);
+}
+
+void BlockingBinaryEncoder::encodeLong(int64_t l) {
+    doEncodeLong(target_, l);
+}
+
+void BlockingBinaryEncoder::encodeFloat(float f) {
+    doWriteBytes(target_, reinterpret_cast<const uint8_t *>(&f), sizeof(float));
+}
+
+void BlockingBinaryEncoder::encodeDouble(double d) {
+    doWriteBytes(target_, reinterpret_cast<const uint8_t *>(&d), sizeof(double));
+}
+
+void BlockingBinaryEncoder::encodeString(const std::string &s) {
+    encodeString(s.data(), s.size());
+}
+
+void BlockingBinaryEncoder::encodeString(const char *s, size_t len) {
+    doEncodeLong(target_, len);
+    doWriteBytes(target_, reinterpret_cast<const uint8_t *>(s), len);
+}
+
+void BlockingBinaryEncoder::encodeBytes(const uint8_t *bytes, size_t len) {
+    doEncodeLong(target_, len);
+    doWriteBytes(target_, bytes, len);
+}
+
+void BlockingBinaryEncoder::encodeFixed(const uint8_t *bytes, size_t len) {
+    doWriteBytes(target_, bytes, len);
+}
+
+void BlockingBinaryEncoder::encodeEnum(size_t e) {
+    doEncodeLong(target_, e);
+}
+
+void BlockingBinaryEncoder::arrayStart() {
+    containerStart();
+}
+
+void BlockingBinaryEncoder::arrayEnd() {
+    containerEnd();
+}
+
+void BlockingBinaryEncoder::mapStart() {
+    containerStart();
+}
+
+void BlockingBinaryEncoder::mapEnd() {
+    containerEnd();
+}
+
+void BlockingBinaryEncoder::setItemCount(size_t count) {
+    if (count == 0) {
+        throw Exception("Count cannot be zero");
+    }
+    if (depth_ == 0) {
+        throw Exception("Item count outside an array or a map");
+    }
+    Block &b = blocks_[depth_ - 1];
+    if (b.open) {
+        closeBlock();
+    }
+    b.count = count;
+    b.open = true;
+    b.buffered = true;
+    target_ = &b.data;
+}
+
+void BlockingBinaryEncoder::startItem() {
+}
+
+void BlockingBinaryEncoder::encodeUnionIndex(size_t e) {
+    doEncodeLong(target_, e);
+}
+
+void BlockingBinaryEncoder::containerStart() {
+    if (blocks_.size() == depth_) {
+        blocks_.emplace_back();
+    }
+    blocks_[depth_].open = false;
+    ++depth_;
+    // Growing blocks_ may have moved the buffers.
+    target_ = targetAt(depth_ - 1);
+}
+
+void BlockingBinaryEncoder::containerEnd() {
+    if (depth_ == 0) {
+        throw Exception("End of an array or a map without a start");
+    }
+    if (blocks_[depth_ - 1].open) {
+        closeBlock();
+    }
+    --depth_;
+    target_ = depth_ == 0 ? nullptr : targetAt(depth_ - 1);
+    doEncodeLong(target_, 0);
+}
+
+std::vector<uint8_t> *BlockingBinaryEncoder::targetAt(size_t depth) {
+    // Only the innermost array or map can be without an open block, and
+    // only between its start and the first item count.
+    for (size_t i = depth + 1; i > 0; --i) {
+        Block &b = blocks_[i - 1];
+        if (b.open) {
+            return b.buffered ? &b.data : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+void BlockingBinaryEncoder::closeBlock() {
+    Block &b = blocks_[depth_ - 1];
+    b.open = false;
+    target_ = targetAt(depth_ - 1);
+    if (b.buffered) {
+        // Each write may spill the enclosing blocks, which resets target_.
+        buffered_ -= b.data.size();
+        doEncodeLong(target_, -static_cast<int64_t>(b.count));
+        doEncodeLong(target_, static_cast<int64_t>(b.data.size()));
+        doWriteBytes(target_, b.data.data(), b.data.size());
+        b.data.clear();
+    }
+}
+
+void BlockingBinaryEncoder::spill() {
+    // Write out the pending blocks, outermost first, in the plain form.
+    // From here on their items go straight to the stream.
+    for (size_t i = 0; i < depth_; ++i) {
+        Block &b = blocks_[i];
+        if (b.open && b.buffered) {
+            doEncodeLong(nullptr, static_cast<int64_t>(b.count));
+            out_.writeBytes(b.data.data(), b.data.size());
+            b.data.clear();
+            b.buffered = false;
+        }
+    }
+    buffered_ = 0;
+    target_ = nullptr;
+}
+
+void BlockingBinaryEncoder::doWriteBytes(std::vector<uint8_t> *target,
+                                         const uint8_t *bytes, size_t len) {
+    if (target == nullptr) {
+        out_.writeBytes(bytes, len);
+    } else {
+        target->insert(target->end(), bytes, bytes + len);
+        buffered_ += len;
+        if (buffered_ > maxBufferSize_) {
+            spill();
+        }
+    }
+}
+
+void BlockingBinaryEncoder::doEncodeLong(std::vector<uint8_t> *target, int64_t l) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+    std::array<uint8_t, 10> bytes;
+    auto size = encodeInt64(l, bytes);
+    doWriteBytes(target, bytes.data(), size);
+}
 } // namespace avro
@@ -146,7 +146,8 @@ struct Field {
     const string name;
     const NodePtr schema;
     const GenericDatum defaultValue;
-    Field(string n, NodePtr v, GenericDatum dv) : name(std::move(n)), schema(std::move(v)), defaultValue(std::move(dv)) {}
+    const FieldOrder order;
+    Field(string n, NodePtr v, GenericDatum dv, FieldOrder o) : name(std::move(n)), schema(std::move(v)), defaultValue(std::move(dv)), order(o) {}
 };
 
 static void assertType(const Entity &e, EntityType et) {
@@ -266,7 +267,18 @@ static Field makeField(const Entity &e, SymbolTable &st, const string &ns) {
         node->setDoc(getDocField(e, m));
     }
     GenericDatum d = (it2 == m.end()) ? GenericDatum() : makeGenericDatum(node, it2->second, st);
-    return Field(n, node, d);
+    FieldOrder order = ORDER_ASCENDING;
+    if (containsField(m, "order")) {
+        const string &o = getStringField(e, m, "order");
+        if (o == "descending") {
+            order = ORDER_DESCENDING;
+        } else if (o == "ignore") {
+            order = ORDER_IGNORE;
+        } else if (o != "ascending") {
+            throw Exception(boost::format("Invalid order for field %1%: %2%") % n % o);
+        }
+    }
+    return Field(n, node, d, order);
 }
 
 // Extended makeRecordNode (with doc).
@@ -277,20 +289,22 @@ static NodePtr makeRecordNode(const Entity &e, const Name &name,
     concepts::MultiAttribute<string> fieldNames;
     concepts::MultiAttribute<NodePtr> fieldValues;
     vector<GenericDatum> defaultValues;
+    vector<FieldOrder> fieldOrders;
 
     for (const auto &it : v) {
         Field f = makeField(it, st, ns);
         fieldNames.add(f.name);
         fieldValues.add(f.schema);
         defaultValues.push_back(f.defaultValue);
+        fieldOrders.push_back(f.order);
     }
     NodeRecord *node;
     if (doc == nullptr) {
         node = new NodeRecord(asSingleAttribute(name), fieldValues, fieldNames,
-                              defaultValues);
+                              defaultValues, fieldOrders);
     } else {
         node = new NodeRecord(asSingleAttribute(name), asSingleAttribute(*doc),
-                              fieldValues, fieldNames, defaultValues);
+                              fieldValues, fieldNames, defaultValues, fieldOrders);
     }
     return NodePtr(node);
 }
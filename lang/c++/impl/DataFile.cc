@@ -55,6 +55,11 @@ const string AVRO_SNAPPY_CODEC = "snappy";
 const size_t minSyncInterval = 32;
 const size_t maxSyncInterval = 1u << 30;
 
+// Blocks are buffered in chunks that start small and double in size, so
+// that large blocks do not end up in hundreds of small chunks.
+const size_t minBlockChunkSize = 4 * 1024;
+const size_t maxBlockChunkSize = 1024 * 1024;
+
 boost::iostreams::zlib_params get_zlib_params() {
     boost::iostreams::zlib_params ret;
     ret.method = boost::iostreams::zlib::deflated;
@@ -64,30 +69,31 @@ boost::iostreams::zlib_params get_zlib_params() {
 } // namespace
 
 DataFileWriterBase::DataFileWriterBase(const char *filename, const ValidSchema &schema, size_t syncInterval,
-                                       Codec codec) : filename_(filename),
-                                                      schema_(schema),
-                                                      encoderPtr_(binaryEncoder()),
-                                                      syncInterval_(syncInterval),
-                                                      codec_(codec),
-                                                      stream_(fileOutputStream(filename)),
-                                                      buffer_(memoryOutputStream()),
-                                                      sync_(makeSync()),
-                                                      objectCount_(0),
-                                                      lastSync_(0) {
+                                       Codec codec, bool sizedBlocks) : filename_(filename),
+                                                                        schema_(schema),
+                                                                        encoderPtr_(sizedBlocks ? blockingBinaryEncoder() : binaryEncoder()),
+                                                                        syncInterval_(syncInterval),
+                                                                        codec_(codec),
+                                                                        stream_(fileOutputStream(filename)),
+                                                                        buffer_(memoryOutputStream(minBlockChunkSize, maxBlockChunkSize)),
+                                                                        sync_(makeSync()),
+                                                                        objectCount_(0),
+                                                                        lastSync_(0) {
     init(schema, syncInterval, codec);
 }
 
 DataFileWriterBase::DataFileWriterBase(std::unique_ptr<OutputStream> outputStream,
-                                       const ValidSchema &schema, size_t syncInterval, Codec codec) : filename_(),
-                                                                                                      schema_(schema),
-                                                                                                      encoderPtr_(binaryEncoder()),
-                                                                                                      syncInterval_(syncInterval),
-                                                                                                      codec_(codec),
-                                                                                                      stream_(std::move(outputStream)),
-                                                                                                      buffer_(memoryOutputStream()),
-                                                                                                      sync_(makeSync()),
-                                                                                                      objectCount_(0),
-                                                                                                      lastSync_(0) {
+                                       const ValidSchema &schema, size_t syncInterval, Codec codec,
+                                       bool sizedBlocks) : filename_(),
+                                                           schema_(schema),
+                                                           encoderPtr_(sizedBlocks ? blockingBinaryEncoder() : binaryEncoder()),
+                                                           syncInterval_(syncInterval),
+                                                           codec_(codec),
+                                                           stream_(std::move(outputStream)),
+                                                           buffer_(memoryOutputStream(minBlockChunkSize, maxBlockChunkSize)),
+                                                           sync_(makeSync()),
+                                                           objectCount_(0),
+                                                           lastSync_(0) {
     init(schema, syncInterval, codec);
 }
 
@@ -212,7 +218,7 @@ void DataFileWriterBase::sync() {
 
     lastSync_ = stream_->byteCount();
 
-    buffer_ = memoryOutputStream();
+    resetMemoryOutputStream(*buffer_);
     encoderPtr_->init(*buffer_);
     objectCount_ = 0;
 }
@@ -244,11 +250,13 @@ typedef array<uint8_t, 4> Magic;
 static Magic magic = {{'O', 'b', 'j', '\x01'}};
 
 void DataFileWriterBase::writeHeader() {
-    encoderPtr_->init(*stream_);
-    avro::encode(*encoderPtr_, magic);
-    avro::encode(*encoderPtr_, metadata_);
-    avro::encode(*encoderPtr_, sync_);
-    encoderPtr_->flush();
+    // The header's metadata map is always written in the plain form.
+    EncoderPtr e = binaryEncoder();
+    e->init(*stream_);
+    avro::encode(*e, magic);
+    avro::encode(*e, metadata_);
+    avro::encode(*e, sync_);
+    e->flush();
 }
 
 void DataFileWriterBase::setMetadata(const string &key, const string &value) {
@@ -33,7 +33,7 @@ void GenericContainer::assertType(const NodePtr &schema, Type type) {
     }
 }
 
-GenericReader::GenericReader(ValidSchema s, const DecoderPtr &decoder) : schema_(std::move(s)), isResolving_(dynamic_cast<ResolvingDecoder *>(&(*decoder)) != nullptr),
+GenericReader::GenericReader(ValidSchema s, const DecoderPtr &decoder) : schema_(std::move(s)), isResolving_(decoder->asResolvingDecoder() != nullptr),
                                                                          decoder_(decoder) {
 }
 
@@ -48,9 +48,106 @@ void GenericReader::read(GenericDatum &datum) const {
     read(datum, *decoder_, isResolving_);
 }
 
-void GenericReader::read(GenericDatum &datum, Decoder &d, bool isResolving) {
+namespace {
+
+typedef std::unordered_map<const Node *, vector<GenericDatum>> DatumPool;
+
+GenericDatum takeDatum(DatumPool &pool, const NodePtr &n) {
+    auto it = pool.find(n.get());
+    if (it == pool.end() || it->second.empty()) {
+        return GenericDatum(n);
+    }
+    GenericDatum result = std::move(it->second.back());
+    it->second.pop_back();
+    return result;
+}
+
+void keepDatum(DatumPool &pool, const NodePtr &n, GenericDatum &&datum) {
+    if (!datum.isUnion()) {
+        switch (datum.type()) {
+            case AVRO_NULL:
+            case AVRO_BOOL:
+            case AVRO_INT:
+            case AVRO_LONG:
+            case AVRO_FLOAT:
+            case AVRO_DOUBLE:
+                // Nothing worth keeping.
+                return;
+            default:
+                break;
+        }
+    }
+    pool[n.get()].push_back(std::move(datum));
+}
+
+// Whether the datum was built for the given schema, so that it can be
+// decoded in place. Containers must share the very schema nodes, as their
+// layout and the pool follow them.
+bool builtFor(const GenericDatum &datum, const NodePtr &n) {
+    if (datum.isUnion() || n->type() == AVRO_UNION) {
+        return datum.isUnion() && datum.unionSchema() == n;
+    }
+    switch (n->type()) {
+        case AVRO_RECORD:
+            return datum.type() == AVRO_RECORD && datum.value<GenericRecord>().schema() == n;
+        case AVRO_ENUM:
+            return datum.type() == AVRO_ENUM && datum.value<GenericEnum>().schema() == n;
+        case AVRO_FIXED:
+            return datum.type() == AVRO_FIXED && datum.value<GenericFixed>().schema() == n;
+        case AVRO_ARRAY:
+            return datum.type() == AVRO_ARRAY && datum.value<GenericArray>().schema() == n;
+        case AVRO_MAP:
+            return datum.type() == AVRO_MAP && datum.value<GenericMap>().schema() == n;
+        default:
+            return datum.type() == n->type();
+    }
+}
+
+} // namespace
+
+void GenericReader::readInto(GenericDatum &datum) const {
+    // Only a datum built for another schema, such as a freshly default
+    // constructed one, is replaced; otherwise its storage is reused.
+    const NodePtr &n = schema_.root();
+    if (!builtFor(datum, n)) {
+        datum = takeDatum(pool_, n);
+    }
+    read(datum, *decoder_, isResolving_, &n, &pool_);
+}
+
+void GenericReader::release(GenericDatum &datum) const {
+    keepDatum(pool_, schema_.root(), std::move(datum));
+    datum = GenericDatum();
+}
+
+void GenericReader::clearPool() const {
+    DatumPool().swap(pool_);
+}
+
+size_t GenericReader::pooled() const {
+    size_t result = 0;
+    for (const auto &p : pool_) {
+        result += p.second.size();
+    }
+    return result;
+}
+
+void GenericReader::read(GenericDatum &datum, Decoder &d, bool isResolving,
+                         const NodePtr *schema, DatumPool *pool) {
     if (datum.isUnion()) {
-        datum.selectBranch(d.decodeUnionIndex());
+        size_t b = d.decodeUnionIndex();
+        if (pool != nullptr && b != datum.unionBranch()) {
+            const NodePtr &u = *schema;
+            GenericDatum v = takeDatum(*pool, u->leafAt(b));
+            size_t old = datum.unionBranch();
+            datum.selectBranch(b, v);
+            keepDatum(*pool, u->leafAt(old), std::move(v));
+        } else {
+            datum.selectBranch(b);
+        }
+        if (schema != nullptr) {
+            schema = &(*schema)->leafAt(b);
+        }
     }
     switch (datum.type()) {
         case AVRO_NULL:
@@ -85,14 +182,16 @@ void GenericReader::read(GenericDatum &datum, Decoder &d, bool isResolving) {
             auto &r = datum.value<GenericRecord>();
             size_t c = r.schema()->leaves();
             if (isResolving) {
-                std::vector<size_t> fo =
+                const std::vector<size_t> &fo =
                     static_cast<ResolvingDecoder &>(d).fieldOrder();
                 for (size_t i = 0; i < c; ++i) {
-                    read(r.fieldAt(fo[i]), d, isResolving);
+                    read(r.fieldAt(fo[i]), d, isResolving,
+                         &r.schema()->leafAt(fo[i]), pool);
                 }
             } else {
                 for (size_t i = 0; i < c; ++i) {
-                    read(r.fieldAt(i), d, isResolving);
+                    read(r.fieldAt(i), d, isResolving,
+                         &r.schema()->leafAt(i), pool);
                 }
             }
         } break;
@@ -103,30 +202,46 @@ void GenericReader::read(GenericDatum &datum, Decoder &d, bool isResolving) {
             auto &v = datum.value<GenericArray>();
             vector<GenericDatum> &r = v.value();
             const NodePtr &nn = v.schema()->leafAt(0);
-            r.resize(0);
-            size_t start = 0;
+            size_t n = 0;
             for (size_t m = d.arrayStart(); m != 0; m = d.arrayNext()) {
-                r.resize(r.size() + m);
-                for (; start < r.size(); ++start) {
-                    r[start] = GenericDatum(nn);
-                    read(r[start], d, isResolving);
+                for (; m != 0; --m, ++n) {
+                    if (n == r.size()) {
+                        if (pool != nullptr) {
+                            r.push_back(takeDatum(*pool, nn));
+                        } else {
+                            r.emplace_back(nn);
+                        }
+                    }
+                    read(r[n], d, isResolving, &nn, pool);
                 }
             }
+            if (pool != nullptr) {
+                for (size_t i = n; i < r.size(); ++i) {
+                    keepDatum(*pool, nn, std::move(r[i]));
+                }
+            }
+            r.resize(n);
         } break;
         case AVRO_MAP: {
             auto &v = datum.value<GenericMap>();
             GenericMap::Value &r = v.value();
             const NodePtr &nn = v.schema()->leafAt(1);
-            r.resize(0);
-            size_t start = 0;
+            size_t n = 0;
             for (size_t m = d.mapStart(); m != 0; m = d.mapNext()) {
-                r.resize(r.size() + m);
-                for (; start < r.size(); ++start) {
-                    d.decodeString(r[start].first);
-                    r[start].second = GenericDatum(nn);
-                    read(r[start].second, d, isResolving);
+                for (; m != 0; --m, ++n) {
+                    if (n == r.size()) {
+                        r.emplace_back(std::string(), pool != nullptr ? takeDatum(*pool, nn) : GenericDatum(nn));
+                    }
+                    d.decodeString(r[n].first);
+                    read(r[n].second, d, isResolving, &nn, pool);
+                }
+            }
+            if (pool != nullptr) {
+                for (size_t i = n; i < r.size(); ++i) {
+                    keepDatum(*pool, nn, std::move(r[i].second));
                 }
             }
+            r.resize(n);
         } break;
         default:
             throw Exception(boost::format("Unknown schema type %1%") % toString(datum.type()));
@@ -139,7 +254,7 @@ void GenericReader::read(Decoder &d, GenericDatum &g, const ValidSchema &s) {
 }
 
 void GenericReader::read(Decoder &d, GenericDatum &g) {
-    read(g, d, dynamic_cast<ResolvingDecoder *>(&d) != nullptr);
+    read(g, d, d.asResolvingDecoder() != nullptr);
 }
 
 GenericWriter::GenericWriter(ValidSchema s, EncoderPtr encoder) : schema_(std::move(s)), encoder_(std::move(encoder)) {
@@ -19,6 +19,9 @@
 #include "GenericDatum.hh"
 #include "NodeImpl.hh"
 
+#include <algorithm>
+#include <functional>
+
 using std::string;
 using std::vector;
 
@@ -34,6 +37,11 @@ GenericDatum::GenericDatum(const NodePtr &schema) : type_(schema->type()),
     init(schema);
 }
 
+void GenericDatum::throwScalarMismatch(Type t) const {
+    throw Exception(boost::format("Cannot access %1% value of a %2% datum")
+                    % toString(t) % toString(type_));
+}
+
 void GenericDatum::init(const NodePtr &schema) {
     NodePtr sc = schema;
     if (type_ == AVRO_SYMBOLIC) {
@@ -44,19 +52,19 @@ void GenericDatum::init(const NodePtr &schema) {
     switch (type_) {
         case AVRO_NULL: break;
         case AVRO_BOOL:
-            value_ = bool();
+            scalar_.boolValue = bool();
             break;
         case AVRO_INT:
-            value_ = int32_t();
+            scalar_.intValue = int32_t();
             break;
         case AVRO_LONG:
-            value_ = int64_t();
+            scalar_.longValue = int64_t();
             break;
         case AVRO_FLOAT:
-            value_ = float();
+            scalar_.floatValue = float();
             break;
         case AVRO_DOUBLE:
-            value_ = double();
+            scalar_.doubleValue = double();
             break;
         case AVRO_STRING:
             value_ = string();
@@ -95,4 +103,89 @@ GenericRecord::GenericRecord(const NodePtr &schema) : GenericContainer(AVRO_RECO
 }
 
 GenericFixed::GenericFixed(const NodePtr &schema, const vector<uint8_t> &v) : GenericContainer(AVRO_FIXED, schema), value_(v) {}
+
+// Maps smaller than this are searched linearly.
+static const size_t minIndexedMapSize = 16;
+
+void GenericMap::buildIndex() {
+    if (value_.size() < minIndexedMapSize || (!index_.empty() && indexedSize_ == value_.size())) {
+        return;
+    }
+    size_t size = 2 * minIndexedMapSize;
+    while (size < 2 * value_.size()) {
+        size *= 2;
+    }
+    index_.assign(size, 0);
+    const size_t mask = size - 1;
+    for (size_t n = 0; n < value_.size(); ++n) {
+        size_t i = std::hash<string>()(value_[n].first) & mask;
+        while (index_[i] != 0 && value_[index_[i] - 1].first != value_[n].first) {
+            i = (i + 1) & mask;
+        }
+        if (index_[i] == 0) {
+            index_[i] = n + 1;
+        }
+    }
+    indexedSize_ = value_.size();
+}
+
+GenericMap::Value::const_iterator GenericMap::find(const string &key) const {
+    if (value_.size() < minIndexedMapSize || index_.empty() || indexedSize_ != value_.size()) {
+        return std::find_if(value_.begin(), value_.end(),
+                            [&key](const Value::value_type &e) { return e.first == key; });
+    }
+    const size_t mask = index_.size() - 1;
+    for (size_t i = std::hash<string>()(key) & mask;; i = (i + 1) & mask) {
+        const size_t slot = index_[i];
+        if (slot == 0) {
+            return value_.end();
+        }
+        if (value_[slot - 1].first == key) {
+            return value_.begin() + (slot - 1);
+        }
+    }
+}
+
+GenericFieldPath::GenericFieldPath(const NodePtr &schema, const string &path) {
+    NodePtr n = schema;
+    size_t start = 0;
+    while (true) {
+        if (n->type() == AVRO_SYMBOLIC) {
+            n = resolveSymbol(n);
+        }
+        size_t end = path.find('.', start);
+        string name = path.substr(start, end == string::npos ? end : end - start);
+        if (n->type() != AVRO_RECORD) {
+            throw Exception(boost::format("Cannot look up field %1% in %2% of path %3%") % name % toString(n->type()) % path);
+        }
+        size_t index = 0;
+        if (!n->nameIndex(name, index)) {
+            throw Exception(boost::format("Invalid field name %1% in path %2%") % name % path);
+        }
+        indices_.push_back(index);
+        if (end == string::npos) {
+            break;
+        }
+        n = n->leafAt(index);
+        start = end + 1;
+    }
+}
+
+const GenericDatum &GenericFieldPath::get(const GenericRecord &record) const {
+    const GenericRecord *r = &record;
+    size_t last = indices_.size() - 1;
+    for (size_t i = 0; i < last; ++i) {
+        r = &r->fieldAt(indices_[i]).value<GenericRecord>();
+    }
+    return r->fieldAt(indices_[last]);
+}
+
+GenericDatum &GenericFieldPath::get(GenericRecord &record) const {
+    GenericRecord *r = &record;
+    size_t last = indices_.size() - 1;
+    for (size_t i = 0; i < last; ++i) {
+        r = &r->fieldAt(indices_[i]).value<GenericRecord>();
+    }
+    return r->fieldAt(indices_[last]);
+}
 } // namespace avro
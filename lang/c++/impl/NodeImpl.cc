@@ -274,6 +274,11 @@ void NodeRecord::printJson(std::ostream &os, size_t depth) const {
                                                            depth);
             }
         }
+        if (fieldOrderAt(i) != ORDER_ASCENDING) {
+            os << ",\n"
+               << indent(depth) << "\"order\": \""
+               << (fieldOrderAt(i) == ORDER_DESCENDING ? "descending" : "ignore") << '"';
+        }
         os << '\n';
         os << indent(--depth) << '}';
     }
@@ -412,8 +417,10 @@ void NodeRecord::printDefaultToJson(const GenericDatum &g, std::ostream &os,
 NodeRecord::NodeRecord(const HasName &name,
                        const MultiLeaves &fields,
                        const LeafNames &fieldsNames,
-                       std::vector<GenericDatum> dv) : NodeImplRecord(AVRO_RECORD, name, fields, fieldsNames, NoSize()),
-                                                       defaultValues(std::move(dv)) {
+                       std::vector<GenericDatum> dv,
+                       std::vector<FieldOrder> fo) : NodeImplRecord(AVRO_RECORD, name, fields, fieldsNames, NoSize()),
+                                                     defaultValues(std::move(dv)),
+                                                     fieldOrders(std::move(fo)) {
     for (size_t i = 0; i < leafNameAttributes_.size(); ++i) {
         if (!nameIndex_.add(leafNameAttributes_.get(i), i)) {
             throw Exception(boost::format(
@@ -17,6 +17,7 @@
  */
 
 #include "Stream.hh"
+#include <algorithm>
 #include <vector>
 
 namespace avro {
@@ -25,20 +26,26 @@ using std::vector;
 
 class MemoryInputStream : public InputStream {
     const std::vector<uint8_t *> &data_;
-    const size_t chunkSize_;
+    const std::vector<size_t> &sizes_;
     const size_t size_;
     const size_t available_;
     size_t cur_;
     size_t curLen_;
+    size_t prevLen_;
+
+    size_t chunkLen(size_t i) const {
+        return (i == (size_ - 1)) ? available_ : sizes_[i];
+    }
 
     size_t maxLen() {
-        size_t n = (cur_ == (size_ - 1)) ? available_ : chunkSize_;
+        size_t n = chunkLen(cur_);
         if (n == curLen_) {
             if (cur_ == (size_ - 1)) {
                 return 0;
             }
+            prevLen_ += n;
             ++cur_;
-            n = (cur_ == (size_ - 1)) ? available_ : chunkSize_;
+            n = chunkLen(cur_);
             curLen_ = 0;
         }
         return n;
@@ -46,8 +53,9 @@ class MemoryInputStream : public InputStream {
 
 public:
     MemoryInputStream(const std::vector<uint8_t *> &b,
-                      size_t chunkSize, size_t available) : data_(b), chunkSize_(chunkSize), size_(b.size()),
-                                                            available_(available), cur_(0), curLen_(0) {}
+                      const std::vector<size_t> &sizes, size_t size,
+                      size_t available) : data_(b), sizes_(sizes), size_(size),
+                                          available_(available), cur_(0), curLen_(0), prevLen_(0) {}
 
     bool next(const uint8_t **data, size_t *len) final {
         if (size_t n = maxLen()) {
@@ -78,7 +86,7 @@ public:
     }
 
     size_t byteCount() const final {
-        return cur_ * chunkSize_ + curLen_;
+        return prevLen_ + curLen_;
     }
 };
 
@@ -120,25 +128,46 @@ public:
 class MemoryOutputStream : public OutputStream {
 public:
     const size_t chunkSize_;
+    const size_t maxChunkSize_;
+    const MemoryChunkPoolPtr pool_;
     std::vector<uint8_t *> data_;
+    std::vector<size_t> sizes_;
+    size_t used_;
     size_t available_;
     size_t byteCount_;
 
-    explicit MemoryOutputStream(size_t chunkSize) : chunkSize_(chunkSize),
-                                                    available_(0), byteCount_(0) {}
+    MemoryOutputStream(size_t chunkSize, size_t maxChunkSize,
+                       MemoryChunkPoolPtr pool) : chunkSize_(chunkSize),
+                                                  maxChunkSize_(std::max(chunkSize, maxChunkSize)),
+                                                  pool_(std::move(pool)),
+                                                  used_(0), available_(0), byteCount_(0) {}
     ~MemoryOutputStream() final {
-        for (std::vector<uint8_t *>::const_iterator it = data_.begin();
-             it != data_.end(); ++it) {
-            delete[] * it;
+        for (size_t i = 0; i < data_.size(); ++i) {
+            if (pool_ && sizes_[i] == pool_->chunkSize()) {
+                pool_->release(data_[i]);
+            } else {
+                delete[] data_[i];
+            }
         }
     }
 
+    void allocate() {
+        size_t n = chunkSize_;
+        if (!sizes_.empty()) {
+            n = std::min(sizes_.back() * 2, maxChunkSize_);
+        }
+        data_.push_back(pool_ && n == pool_->chunkSize() ? pool_->acquire() : new uint8_t[n]);
+        sizes_.push_back(n);
+    }
+
     bool next(uint8_t **data, size_t *len) final {
         if (available_ == 0) {
-            data_.push_back(new uint8_t[chunkSize_]);
-            available_ = chunkSize_;
+            if (used_ == data_.size()) {
+                allocate();
+            }
+            available_ = sizes_[used_++];
         }
-        *data = &data_.back()[chunkSize_ - available_];
+        *data = &data_[used_ - 1][sizes_[used_ - 1] - available_];
         *len = available_;
         byteCount_ += available_;
         available_ = 0;
@@ -155,10 +184,67 @@ public:
     }
 
     void flush() final {}
+
+    void reset() {
+        used_ = 0;
+        available_ = 0;
+        byteCount_ = 0;
+    }
 };
 
+MemoryChunkPool::MemoryChunkPool(size_t chunkSize, size_t maxChunks)
+    : chunkSize_(chunkSize), maxChunks_(maxChunks) {
+    free_.reserve(maxChunks);
+}
+
+MemoryChunkPool::~MemoryChunkPool() {
+    for (uint8_t *p : free_) {
+        delete[] p;
+    }
+}
+
+uint8_t *MemoryChunkPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            uint8_t *result = free_.back();
+            free_.pop_back();
+            return result;
+        }
+    }
+    return new uint8_t[chunkSize_];
+}
+
+void MemoryChunkPool::release(uint8_t *chunk) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < maxChunks_) {
+            free_.push_back(chunk);
+            return;
+        }
+    }
+    delete[] chunk;
+}
+
+size_t MemoryChunkPool::pooled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+}
+
 std::unique_ptr<OutputStream> memoryOutputStream(size_t chunkSize) {
-    return std::unique_ptr<OutputStream>(new MemoryOutputStream(chunkSize));
+    return std::unique_ptr<OutputStream>(new MemoryOutputStream(chunkSize, chunkSize, MemoryChunkPoolPtr()));
+}
+
+std::unique_ptr<OutputStream> memoryOutputStream(size_t chunkSize, size_t maxChunkSize) {
+    return std::unique_ptr<OutputStream>(new MemoryOutputStream(chunkSize, maxChunkSize, MemoryChunkPoolPtr()));
+}
+
+std::unique_ptr<OutputStream> memoryOutputStream(const MemoryChunkPoolPtr &pool) {
+    return std::unique_ptr<OutputStream>(new MemoryOutputStream(pool->chunkSize(), pool->chunkSize(), pool));
+}
+
+void resetMemoryOutputStream(OutputStream &source) {
+    dynamic_cast<MemoryOutputStream &>(source).reset();
 }
 
 std::unique_ptr<InputStream> memoryInputStream(const uint8_t *data, size_t len) {
@@ -168,7 +254,7 @@ std::unique_ptr<InputStream> memoryInputStream(const uint8_t *data, size_t len)
 std::unique_ptr<InputStream> memoryInputStream(const OutputStream &source) {
     const auto &mos =
         dynamic_cast<const MemoryOutputStream &>(source);
-    return (mos.data_.empty()) ? std::unique_ptr<InputStream>(new MemoryInputStream2(nullptr, 0)) : std::unique_ptr<InputStream>(new MemoryInputStream(mos.data_, mos.chunkSize_, (mos.chunkSize_ - mos.available_)));
+    return (mos.used_ == 0) ? std::unique_ptr<InputStream>(new MemoryInputStream2(nullptr, 0)) : std::unique_ptr<InputStream>(new MemoryInputStream(mos.data_, mos.sizes_, mos.used_, (mos.sizes_[mos.used_ - 1] - mos.available_)));
 }
 
 std::shared_ptr<std::vector<uint8_t>> snapshot(const OutputStream &source) {
@@ -177,10 +263,9 @@ std::shared_ptr<std::vector<uint8_t>> snapshot(const OutputStream &source) {
     std::shared_ptr<std::vector<uint8_t>> result(new std::vector<uint8_t>());
     size_t c = mos.byteCount_;
     result->reserve(mos.byteCount_);
-    for (auto it = mos.data_.begin();
-         it != mos.data_.end(); ++it) {
-        size_t n = std::min(c, mos.chunkSize_);
-        std::copy(*it, *it + n, std::back_inserter(*result));
+    for (size_t i = 0; i < mos.used_; ++i) {
+        size_t n = std::min(c, mos.sizes_[i]);
+        std::copy(mos.data_[i], mos.data_[i] + n, std::back_inserter(*result));
         c -= n;
     }
     return result;
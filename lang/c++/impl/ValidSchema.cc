@@ -18,6 +18,7 @@
 
 #include <boost/format.hpp>
 #include <cctype>
+#include <set>
 #include <sstream>
 #include <utility>
 
@@ -129,6 +130,104 @@ void ValidSchema::toFlatList(std::ostream &os) const {
     root_->printBasicInfo(os);
 }
 
+static void printCanonical(std::ostream &os, const NodePtr &node,
+                           std::set<std::string> &seen) {
+    Type t = node->type();
+    if (isPrimitive(t)) {
+        os << '"' << toString(t) << '"';
+        return;
+    }
+    if (node->hasName()) {
+        std::string name = node->name().fullname();
+        if (t == AVRO_SYMBOLIC || !seen.insert(name).second) {
+            os << '"' << name << '"';
+            return;
+        }
+        os << "{\"name\":\"" << name << "\",\"type\":\"" << toString(t) << '"';
+    } else if (t != AVRO_UNION) {
+        os << "{\"type\":\"" << toString(t) << '"';
+    }
+
+    switch (t) {
+        case AVRO_RECORD:
+            os << ",\"fields\":[";
+            for (size_t i = 0; i < node->leaves(); ++i) {
+                if (i != 0) {
+                    os << ',';
+                }
+                os << "{\"name\":\"" << node->nameAt(i) << "\",\"type\":";
+                printCanonical(os, node->leafAt(i), seen);
+                os << '}';
+            }
+            os << "]}";
+            break;
+        case AVRO_ENUM:
+            os << ",\"symbols\":[";
+            for (size_t i = 0; i < node->names(); ++i) {
+                if (i != 0) {
+                    os << ',';
+                }
+                os << '"' << node->nameAt(i) << '"';
+            }
+            os << "]}";
+            break;
+        case AVRO_ARRAY:
+            os << ",\"items\":";
+            printCanonical(os, node->leafAt(0), seen);
+            os << '}';
+            break;
+        case AVRO_MAP:
+            os << ",\"values\":";
+            printCanonical(os, node->leafAt(1), seen);
+            os << '}';
+            break;
+        case AVRO_FIXED:
+            os << ",\"size\":" << node->fixedSize() << '}';
+            break;
+        case AVRO_UNION:
+            os << '[';
+            for (size_t i = 0; i < node->leaves(); ++i) {
+                if (i != 0) {
+                    os << ',';
+                }
+                printCanonical(os, node->leafAt(i), seen);
+            }
+            os << ']';
+            break;
+        default:
+            throw Exception(format("Unexpected type %1% in canonical form") % t);
+    }
+}
+
+string ValidSchema::toCanonicalJson() const {
+    ostringstream oss;
+    std::set<std::string> seen;
+    printCanonical(oss, root_, seen);
+    return oss.str();
+}
+
+uint64_t ValidSchema::fingerprint() const {
+    static const uint64_t empty = 0xc15d213aa4d7a795ULL;
+    static const struct Table {
+        uint64_t v[256];
+        Table() : v() {
+            for (uint64_t i = 0; i < 256; ++i) {
+                uint64_t fp = i;
+                for (int j = 0; j < 8; ++j) {
+                    fp = (fp >> 1) ^ (empty & (0 - (fp & 1)));
+                }
+                v[i] = fp;
+            }
+        }
+    } table;
+
+    uint64_t fp = empty;
+    for (char c : toCanonicalJson()) {
+        fp = (fp >> 8) ^ table.v[(fp ^ static_cast<uint8_t>(c)) & 0xff];
+    }
+    return fp;
+}
+
 /*
  * compactSchema compacts and returns a formatted string representation
  * of a ValidSchema object by removing the whitespaces outside of the quoted
@@ -16,14 +16,19 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cctype>
 #ifndef _WIN32
 #include <ctime>
 #endif
+#include <cmath>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <set>
+#include <sstream>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
@@ -35,7 +40,11 @@
 #include <boost/algorithm/string_regex.hpp>
 
 #include "Compiler.hh"
+#include "Encoder.hh"
+#include "Generic.hh"
 #include "NodeImpl.hh"
+#include "Specific.hh"
+#include "Stream.hh"
 #include "ValidSchema.hh"
 
 using avro::NodePtr;
@@ -84,6 +93,13 @@ class CodeGen {
     const std::string headerFile_;
     const std::string includePrefix_;
     const bool noUnion_;
+    const bool taggedUnions_;
+    const bool views_;
+    const bool pmr_;
+    const bool compare_;
+    const std::string mapContainer_;
+    const std::string arrayContainer_;
+    const size_t arrayCapacity_;
     const std::string guardString_;
     boost::mt19937 random_;
 
@@ -92,14 +108,35 @@ class CodeGen {
 
     map<NodePtr, string> done;
     set<NodePtr> doing;
+    set<NodePtr> tagged;
+
+    string resolvedSuffix_;
+    map<std::pair<NodePtr, NodePtr>, string> resolvedDone_;
+    map<NodePtr, string> skipDone_;
+    vector<string> resolvedDecls_;
+    vector<string> resolvedDefs_;
+    bool viewSkips_;
+    vector<std::pair<NodePtr, string>> comparable_;
+    map<NodePtr, bool> ordered_;
+    NodePtr root_;
+    string schemaJson_;
+    string canonicalJson_;
+    uint64_t fingerprint_;
 
     std::string guard();
     std::string fullname(const string &name) const;
     std::string generateEnumType(const NodePtr &n);
     std::string cppTypeOf(const NodePtr &n);
+    std::string arrayType(const std::string &items) const;
+    std::string mapType(const std::string &values) const;
     std::string generateRecordType(const NodePtr &n);
+    void generateAllocatorConstructors(const NodePtr &n, const std::string &name);
+    void generateSchemaMembers(const NodePtr &n);
     std::string unionName();
     std::string generateUnionType(const NodePtr &n);
+    void generateTaggedUnionType(const NodePtr &n, const string &name,
+                                 const vector<string> &types,
+                                 const vector<string> &names);
     std::string generateType(const NodePtr &n);
     std::string generateDeclaration(const NodePtr &n);
     std::string doGenerateType(const NodePtr &n);
@@ -107,18 +144,49 @@ class CodeGen {
     void generateTraits(const NodePtr &n);
     void generateRecordTraits(const NodePtr &n);
     void generateUnionTraits(const NodePtr &n);
+    void generateTaggedUnionTraits(const NodePtr &n);
+    void generateUnionEncodedSize(const NodePtr &n);
+    void generateResolvedDecoders(const ValidSchema &schema,
+                                  const vector<ValidSchema> &writers);
+    void generateResolvedRead(ostream &os, const NodePtr &w, const NodePtr &r,
+                              const string &target, const string &indent,
+                              size_t depth);
+    void generateSkip(ostream &os, const NodePtr &w, const string &indent,
+                      size_t depth);
+    void generateDefault(ostream &os, const NodePtr &r, const avro::GenericDatum &datum,
+                         const string &target, const string &indent);
+    string resolvedRecordDecoder(const NodePtr &w, const NodePtr &r);
+    string recordSkipper(const NodePtr &w);
+    void generateViews(const NodePtr &root);
+    void generateViewMembers(const NodePtr &n);
+    string comparisonCall(const NodePtr &n, const string &fn, const string &args);
+    string unionValue(const NodePtr &u, size_t i, const string &v);
+    bool hasOrder(const NodePtr &n);
+    void generateFriendComparisons(const NodePtr &n, const string &name);
+    void generateComparisons();
+    void generateRecordComparisons(const NodePtr &n, const string &name);
+    void generateUnionComparisons(const NodePtr &n, const string &name);
+    void generateHashSpecializations();
     void emitCopyright();
 
 public:
     CodeGen(std::ostream &os, std::string ns,
             std::string schemaFile, std::string headerFile,
             std::string guardString,
-            std::string includePrefix, bool noUnion) : unionNumber_(0), os_(os), inNamespace_(false), ns_(std::move(ns)),
-                                                       schemaFile_(std::move(schemaFile)), headerFile_(std::move(headerFile)),
-                                                       includePrefix_(std::move(includePrefix)), noUnion_(noUnion),
-                                                       guardString_(std::move(guardString)),
-                                                       random_(static_cast<uint32_t>(::time(nullptr))) {}
-    void generate(const ValidSchema &schema);
+            std::string includePrefix, bool noUnion,
+            bool taggedUnions, bool views, bool pmr, bool compare,
+            std::string mapContainer, std::string arrayContainer,
+            size_t arrayCapacity) : unionNumber_(0), os_(os), inNamespace_(false), ns_(std::move(ns)),
+                                    schemaFile_(std::move(schemaFile)), headerFile_(std::move(headerFile)),
+                                    includePrefix_(std::move(includePrefix)), noUnion_(noUnion),
+                                    taggedUnions_(taggedUnions), views_(views), pmr_(pmr), compare_(compare),
+                                    mapContainer_(std::move(mapContainer)), arrayContainer_(std::move(arrayContainer)),
+                                    arrayCapacity_(arrayCapacity),
+                                    guardString_(std::move(guardString)),
+                                    random_(static_cast<uint32_t>(::time(nullptr))), viewSkips_(false),
+                                    fingerprint_(0) {}
+    void generate(const ValidSchema &schema,
+                  const vector<ValidSchema> &writers = vector<ValidSchema>());
 };
 
 static string decorate(const std::string &name) {
@@ -163,9 +231,9 @@ string CodeGen::generateEnumType(const NodePtr &n) {
 string CodeGen::cppTypeOf(const NodePtr &n) {
     switch (n->type()) {
         case avro::AVRO_STRING:
-            return "std::string";
+            return pmr_ ? "std::pmr::string" : "std::string";
         case avro::AVRO_BYTES:
-            return "std::vector<uint8_t>";
+            return pmr_ ? "std::pmr::vector<uint8_t>" : "std::vector<uint8_t>";
         case avro::AVRO_INT:
             return "int32_t";
         case avro::AVRO_LONG:
@@ -182,9 +250,9 @@ string CodeGen::cppTypeOf(const NodePtr &n) {
             return inNamespace_ ? nm : fullname(nm);
         }
         case avro::AVRO_ARRAY:
-            return "std::vector<" + cppTypeOf(n->leafAt(0)) + " >";
+            return arrayType(cppTypeOf(n->leafAt(0)));
         case avro::AVRO_MAP:
-            return "std::map<std::string, " + cppTypeOf(n->leafAt(1)) + " >";
+            return mapType(cppTypeOf(n->leafAt(1)));
         case avro::AVRO_FIXED:
             return "std::array<uint8_t, " + lexical_cast<string>(n->fixedSize()) + ">";
         case avro::AVRO_SYMBOLIC:
@@ -198,6 +266,22 @@ string CodeGen::cppTypeOf(const NodePtr &n) {
     }
 }
 
+string CodeGen::arrayType(const string &items) const {
+    if (!arrayContainer_.empty()) {
+        return arrayContainer_ + "<" + items + ", " + lexical_cast<string>(arrayCapacity_) + " >";
+    }
+    return (pmr_ ? "std::pmr::vector<" : "std::vector<") + items + " >";
+}
+
+string CodeGen::mapType(const string &values) const {
+    const string prefix = pmr_ ? "std::pmr::" : "std::";
+    const string key = prefix + "string";
+    if (mapContainer_ == "flat") {
+        return prefix + "vector<std::pair<" + key + ", " + values + " > >";
+    }
+    return prefix + mapContainer_ + "<" + key + ", " + values + " >";
+}
+
 static string cppNameOf(const NodePtr &n) {
     switch (n->type()) {
         case avro::AVRO_NULL:
@@ -231,6 +315,117 @@ static string cppNameOf(const NodePtr &n) {
     }
 }
 
+static bool usesAllocator(const NodePtr &n) {
+    switch (n->type()) {
+        case avro::AVRO_STRING:
+        case avro::AVRO_BYTES:
+        case avro::AVRO_ARRAY:
+        case avro::AVRO_MAP:
+        case avro::AVRO_RECORD:
+            return true;
+        case avro::AVRO_SYMBOLIC:
+            return usesAllocator(resolveSymbol(n));
+        default:
+            return false;
+    }
+}
+
+/**
+ * Emits the allocator-extended constructors that make a record usable
+ * with std::pmr containers: the containers within a record created in
+ * one then allocate from the same memory resource. Unions hold their
+ * values as they otherwise would.
+ */
+void CodeGen::generateAllocatorConstructors(const NodePtr &n, const string &name) {
+    size_t c = n->leaves();
+    bool anyAware = false;
+    for (size_t i = 0; i < c; ++i) {
+        anyAware = anyAware || usesAllocator(n->leafAt(i));
+    }
+    const char *forms[] = {"", "o.", "std::move(o."};
+    os_ << "    typedef std::pmr::polymorphic_allocator<char> allocator_type;\n";
+    for (int f = 0; f < 3; ++f) {
+        os_ << "    " << (f == 0 ? "explicit " : "") << name << "("
+            << (f == 1 ? "const " + name + " &o, " : f == 2 ? name + " &&o, " : "")
+            << "const allocator_type &" << (anyAware ? "a" : "") << ")";
+        for (size_t i = 0; i < c; ++i) {
+            bool aware = usesAllocator(n->leafAt(i));
+            string field = decorate(n->nameAt(i));
+            os_ << (i == 0 ? " :\n" : ",\n") << "        " << field << "(";
+            if (f != 0) {
+                os_ << forms[f] << field << (f == 2 ? ")" : "") << (aware ? ", " : "");
+            }
+            os_ << (aware ? "a" : "") << ")";
+        }
+        os_ << " { }\n";
+    }
+    os_ << "    " << name << "(const " << name << " &) = default;\n"
+        << "    " << name << "(" << name << " &&) = default;\n"
+        << "    " << name << " &operator=(const " << name << " &) = default;\n"
+        << "    " << name << " &operator=(" << name << " &&) = default;\n";
+}
+
+/**
+ * Returns s as a C++ string literal, split into pieces that are
+ * concatenated by the compiler so that no line gets too long.
+ */
+static string stringLiteral(const string &s, const string &indent) {
+    std::ostringstream oss;
+    oss << '"';
+    size_t width = 0;
+    for (char ch : s) {
+        if (width >= 100) {
+            oss << "\"\n"
+                << indent << '"';
+            width = 0;
+        }
+        unsigned char c = static_cast<unsigned char>(ch);
+        if (c == '"' || c == '\\' || c == '?') {
+            // A question mark is escaped lest it start a trigraph.
+            oss << '\\' << ch;
+            width += 2;
+        } else if (c < 0x20 || c >= 0x7f) {
+            // Octal escapes take at most three digits, so unlike
+            // hexadecimal ones they cannot run into the next character.
+            oss << '\\' << std::oct << std::setw(3) << std::setfill('0')
+                << static_cast<unsigned>(c) << std::dec;
+            width += 4;
+        } else {
+            oss << ch;
+            ++width;
+        }
+    }
+    oss << '"';
+    return oss.str();
+}
+
+/**
+ * Emits, into the type generated for the root of the schema, the schema
+ * itself: its JSON, its Parsing Canonical Form and fingerprint as
+ * compile-time constants, and the ValidSchema compiled from the JSON on
+ * first use.
+ */
+void CodeGen::generateSchemaMembers(const NodePtr &n) {
+    if (n != root_) {
+        return;
+    }
+    std::ostringstream fp;
+    fp << "0x" << std::hex << std::setw(16) << std::setfill('0') << fingerprint_ << "ULL";
+    os_ << "    static constexpr const char *avroSchemaJson() {\n"
+        << "        return " << stringLiteral(schemaJson_, "            ") << ";\n"
+        << "    }\n"
+        << "    static constexpr const char *avroCanonicalJson() {\n"
+        << "        return " << stringLiteral(canonicalJson_, "            ") << ";\n"
+        << "    }\n"
+        << "    static constexpr uint64_t avroFingerprint() {\n"
+        << "        return " << fp.str() << ";\n"
+        << "    }\n"
+        << "    static const avro::ValidSchema &avroSchema() {\n"
+        << "        static const avro::ValidSchema schema = avro::compileJsonSchemaFromString(avroSchemaJson());\n"
+        << "        return schema;\n"
+        << "    }\n";
+}
+
 string CodeGen::generateRecordType(const NodePtr &n) {
     size_t c = n->leaves();
     string decoratedName = decorate(n->name());
@@ -289,6 +484,10 @@ string CodeGen::generateRecordType(const NodePtr &n) {
         os_ << "\n";
     }
     os_ << "        { }\n";
+    if (pmr_) {
+        generateAllocatorConstructors(n, decoratedName);
+    }
+    generateSchemaMembers(n);
     os_ << "};\n\n";
     return decoratedName;
 }
@@ -361,7 +560,8 @@ string CodeGen::generateUnionType(const NodePtr &n) {
     vector<string> names;
 
     auto it = doing.find(n);
-    if (it != doing.end()) {
+    const bool recursive = it != doing.end();
+    if (recursive) {
         for (size_t i = 0; i < c; ++i) {
             const NodePtr &nn = n->leafAt(i);
             types.push_back(generateDeclaration(nn));
@@ -382,6 +582,14 @@ string CodeGen::generateUnionType(const NodePtr &n) {
 
     auto result = unionName();
 
+    // The branches of a union within a recursive type may only be
+    // declared at this point, so such unions cannot hold them inline.
+    if (taggedUnions_ && !recursive) {
+        generateTaggedUnionType(n, result, types, names);
+        tagged.insert(n);
+        return result;
+    }
+
     os_ << "struct " << result << " {\n"
         << "private:\n"
         << "    size_t idx_;\n"
@@ -412,11 +620,164 @@ string CodeGen::generateUnionType(const NodePtr &n) {
     os_ << "    " << result << "();\n";
     pendingConstructors.emplace_back(result, types[0],
                                      n->leafAt(0)->type() != avro::AVRO_NULL);
+    if (compare_) {
+        generateFriendComparisons(n, result);
+    }
+    generateSchemaMembers(n);
     os_ << "};\n\n";
 
     return result;
 }
 
+/**
+ * Emits a union that holds the value of the current branch inline, in a
+ * C++ union, rather than in an any. All branch types must be complete.
+ */
+void CodeGen::generateTaggedUnionType(const NodePtr &n, const string &name,
+                                      const vector<string> &types,
+                                      const vector<string> &names) {
+    size_t c = n->leaves();
+    vector<size_t> values;
+    for (size_t i = 0; i < c; ++i) {
+        if (n->leafAt(i)->type() != avro::AVRO_NULL) {
+            values.push_back(i);
+        }
+    }
+
+    os_ << "struct " << name << " {\n"
+        << "private:\n";
+    for (size_t i : values) {
+        os_ << "    typedef " << types[i] << " t" << i << "_;\n";
+    }
+    // While no branch is constructed, idx_ is the number of branches.
+    os_ << "    size_t idx_;\n";
+    if (!values.empty()) {
+        os_ << "    union {\n";
+        for (size_t i : values) {
+            os_ << "        t" << i << "_ v" << i << "_;\n";
+        }
+        os_ << "    };\n";
+    }
+    os_ << "    void destroy_() {\n"
+        << "        switch (idx_) {\n";
+    for (size_t i : values) {
+        os_ << "        case " << i << ":\n"
+            << "            v" << i << "_.~t" << i << "_();\n"
+            << "            break;\n";
+    }
+    os_ << "        default:\n"
+        << "            break;\n"
+        << "        }\n"
+        << "        idx_ = " << c << ";\n"
+        << "    }\n"
+        << "public:\n"
+        << "    size_t idx() const { return idx_; }\n";
+
+    for (size_t i = 0; i < c; ++i) {
+        if (n->leafAt(i)->type() == avro::AVRO_NULL) {
+            os_ << "    bool is_null() const {\n"
+                << "        return (idx_ == " << i << ");\n"
+                << "    }\n"
+                << "    void set_null() {\n"
+                << "        destroy_();\n"
+                << "        idx_ = " << i << ";\n"
+                << "    }\n";
+            continue;
+        }
+        const string &t = types[i];
+        const string tn = "t" + lexical_cast<string>(i) + "_";
+        const string v = "v" + lexical_cast<string>(i) + "_";
+        const string check = "        if (idx_ != " + lexical_cast<string>(i) + ") {\n"
+                             + "            throw avro::Exception(\"Invalid type for union\");\n"
+                             + "        }\n";
+        os_ << "    const " << t << "& get_" << names[i] << "() const {\n"
+            << check
+            << "        return " << v << ";\n"
+            << "    }\n"
+            << "    " << t << "& get_" << names[i] << "() {\n"
+            << check
+            << "        return " << v << ";\n"
+            << "    }\n"
+            << "    void set_" << names[i] << "(const " << t << "& v) {\n"
+            << "        if (idx_ == " << i << ") {\n"
+            << "            " << v << " = v;\n"
+            << "        } else {\n"
+            << "            emplace_" << names[i] << "(v);\n"
+            << "        }\n"
+            << "    }\n"
+            << "    void set_" << names[i] << "(" << t << "&& v) {\n"
+            << "        if (idx_ == " << i << ") {\n"
+            << "            " << v << " = std::move(v);\n"
+            << "        } else {\n"
+            << "            emplace_" << names[i] << "(std::move(v));\n"
+            << "        }\n"
+            << "    }\n"
+            << "    template<typename... A>\n"
+            << "    " << t << "& emplace_" << names[i] << "(A&&... a) {\n"
+            << "        destroy_();\n"
+            << "        new (&" << v << ") " << tn << "(std::forward<A>(a)...);\n"
+            << "        idx_ = " << i << ";\n"
+            << "        return " << v << ";\n"
+            << "    }\n";
+    }
+
+    // Moves go through set_X(), which move constructs or move assigns the
+    // branch, so they do not throw only if no branch type does.
+    string nothrowMove = "noexcept";
+    for (size_t i : values) {
+        nothrowMove += (i == values.front() ? "(\n        " : "\n        && ");
+        nothrowMove += "std::is_nothrow_move_constructible<t" + lexical_cast<string>(i)
+            + "_>::value && std::is_nothrow_move_assignable<t" + lexical_cast<string>(i) + "_>::value";
+    }
+    if (!values.empty()) {
+        nothrowMove += ")";
+    }
+
+    const string &first = names[0];
+    os_ << "    " << name << "() : idx_(" << c << ") {\n"
+        << (n->leafAt(0)->type() == avro::AVRO_NULL ? "        set_null();\n" : "        emplace_" + first + "();\n")
+        << "    }\n"
+        << "    " << name << "(const " << name << "& o) : idx_(" << c << ") {\n"
+        << "        *this = o;\n"
+        << "    }\n"
+        << "    " << name << "(" << name << "&& o) " << nothrowMove << " : idx_(" << c << ") {\n"
+        << "        *this = std::move(o);\n"
+        << "    }\n"
+        << "    ~" << name << "() {\n"
+        << "        destroy_();\n"
+        << "    }\n";
+    const char *refs[] = {"const ", ""};
+    for (const char *ref : refs) {
+        bool isMove = *ref == '\0';
+        os_ << "    " << name << "& operator=(" << ref << name << (isMove ? "&& o) " + nothrowMove + " {\n" : "& o) {\n")
+            << "        if (this != &o) {\n"
+            << "            switch (o.idx_) {\n";
+        for (size_t i = 0; i < c; ++i) {
+            os_ << "            case " << i << ":\n";
+            if (n->leafAt(i)->type() == avro::AVRO_NULL) {
+                os_ << "                set_null();\n";
+            } else if (isMove) {
+                os_ << "                set_" << names[i] << "(std::move(o.v" << i << "_));\n";
+            } else {
+                os_ << "                set_" << names[i] << "(o.v" << i << "_);\n";
+            }
+            os_ << "                break;\n";
+        }
+        os_ << "            default:\n"
+            << "                destroy_();\n"
+            << "                break;\n"
+            << "            }\n"
+            << "        }\n"
+            << "        return *this;\n"
+            << "    }\n";
+    }
+    if (compare_) {
+        generateFriendComparisons(n, name);
+    }
+    generateSchemaMembers(n);
+    os_ << "};\n\n";
+}
+
 /**
  * Returns the type for the given schema node and emits code to os.
  */
@@ -429,6 +790,10 @@ string CodeGen::generateType(const NodePtr &n) {
     }
     string result = doGenerateType(nn);
     done[nn] = result;
+    if (compare_ && (nn->type() == avro::AVRO_RECORD || nn->type() == avro::AVRO_ENUM || nn->type() == avro::AVRO_UNION)
+        && std::find(comparable_.begin(), comparable_.end(), std::make_pair(nn, result)) == comparable_.end()) {
+        comparable_.emplace_back(nn, result);
+    }
     return result;
 }
 
@@ -454,7 +819,7 @@ string CodeGen::doGenerateType(const NodePtr &n) {
             } else {
                 dn = generateDeclaration(ln);
             }
-            return "std::vector<" + dn + " >";
+            return arrayType(dn);
         }
         case avro::AVRO_MAP: {
             const NodePtr &ln = n->leafAt(1);
@@ -466,7 +831,7 @@ string CodeGen::doGenerateType(const NodePtr &n) {
             } else {
                 dn = generateDeclaration(ln);
             }
-            return "std::map<std::string, " + dn + " >";
+            return mapType(dn);
         }
         case avro::AVRO_RECORD:
             return generateRecordType(n);
@@ -494,9 +859,9 @@ string CodeGen::generateDeclaration(const NodePtr &n) {
         case avro::AVRO_FIXED:
             return cppTypeOf(nn);
         case avro::AVRO_ARRAY:
-            return "std::vector<" + generateDeclaration(nn->leafAt(0)) + " >";
+            return arrayType(generateDeclaration(nn->leafAt(0)));
         case avro::AVRO_MAP:
-            return "std::map<std::string, " + generateDeclaration(nn->leafAt(1)) + " >";
+            return mapType(generateDeclaration(nn->leafAt(1)));
         case avro::AVRO_RECORD:
             os_ << "struct " << cppTypeOf(nn) << ";\n";
             return cppTypeOf(nn);
@@ -541,6 +906,9 @@ void CodeGen::generateEnumTraits(const NodePtr &n) {
         << "        }\n"
         << "        v = static_cast<" << fn << ">(index);\n"
         << "    }\n"
+        << "    static size_t encodedSize(" << fn << " v) {\n"
+        << "        return avro::encodedLongSize(static_cast<int64_t>(v));\n"
+        << "    }\n"
         << "};\n\n";
 }
 
@@ -563,9 +931,8 @@ void CodeGen::generateRecordTraits(const NodePtr &n) {
 
     os_ << "    }\n"
         << "    static void decode(Decoder& d, " << fn << "& v) {\n";
-    os_ << "        if (avro::ResolvingDecoder *rd =\n";
-    os_ << "            dynamic_cast<avro::ResolvingDecoder *>(&d)) {\n";
-    os_ << "            const std::vector<size_t> fo = rd->fieldOrder();\n";
+    os_ << "        if (avro::ResolvingDecoder *rd = d.asResolvingDecoder()) {\n";
+    os_ << "            const std::vector<size_t> &fo = rd->fieldOrder();\n";
     os_ << "            for (std::vector<size_t>::const_iterator it = fo.begin();\n";
     os_ << "                it != fo.end(); ++it) {\n";
     os_ << "                switch (*it) {\n";
@@ -592,6 +959,13 @@ void CodeGen::generateRecordTraits(const NodePtr &n) {
     os_ << "        }\n";
 
     os_ << "    }\n"
+        << "    static size_t encodedSize(const " << fn << "& " << (c == 0 ? "" : "v") << ") {\n"
+        << "        return 0";
+    for (size_t i = 0; i < c; ++i) {
+        os_ << "\n            + avro::encodedSize(v." << decorate(n->nameAt(i)) << ")";
+    }
+    os_ << ";\n"
+        << "    }\n"
         << "};\n\n";
 }
 
@@ -603,11 +977,16 @@ void CodeGen::generateUnionTraits(const NodePtr &n) {
         generateTraits(nn);
     }
 
+    if (tagged.find(n) != tagged.end()) {
+        generateTaggedUnionTraits(n);
+        return;
+    }
+
     string name = done[n];
     string fn = fullname(name);
 
     os_ << "template<> struct codec_traits<" << fn << "> {\n"
-        << "    static void encode(Encoder& e, " << fn << " v) {\n"
+        << "    static void encode(Encoder& e, const " << fn << "& v) {\n"
         << "        e.encodeUnionIndex(v.idx());\n"
         << "        switch (v.idx()) {\n";
 
@@ -646,9 +1025,86 @@ void CodeGen::generateUnionTraits(const NodePtr &n) {
         }
         os_ << "            break;\n";
     }
+    os_ << "        }\n"
+        << "    }\n";
+    generateUnionEncodedSize(n);
+    os_ << "};\n\n";
+}
+
+/**
+ * Emits the encodedSize() of a union's codec_traits. The branch index is
+ * known here, so its length is a constant.
+ */
+void CodeGen::generateUnionEncodedSize(const NodePtr &n) {
+    size_t c = n->leaves();
+    os_ << "    static size_t encodedSize(const " << fullname(done[n]) << "& v) {\n"
+        << "        switch (v.idx()) {\n";
+    for (size_t i = 0; i < c; ++i) {
+        const NodePtr &nn = n->leafAt(i);
+        size_t indexSize = avro::encodedLongSize(static_cast<int64_t>(i));
+        os_ << "        case " << i << ":\n";
+        if (nn->type() == avro::AVRO_NULL) {
+            os_ << "            return " << indexSize << ";\n";
+        } else {
+            os_ << "            return " << indexSize << " + avro::encodedSize(v.get_"
+                << cppNameOf(nn) << "());\n";
+        }
+    }
+    os_ << "        default:\n"
+        << "            return 0;\n"
+        << "        }\n"
+        << "    }\n";
+}
+
+void CodeGen::generateTaggedUnionTraits(const NodePtr &n) {
+    size_t c = n->leaves();
+    string fn = fullname(done[n]);
+
+    os_ << "template<> struct codec_traits<" << fn << "> {\n"
+        << "    static void encode(Encoder& e, const " << fn << "& v) {\n"
+        << "        e.encodeUnionIndex(v.idx());\n"
+        << "        switch (v.idx()) {\n";
+
+    for (size_t i = 0; i < c; ++i) {
+        const NodePtr &nn = n->leafAt(i);
+        os_ << "        case " << i << ":\n";
+        if (nn->type() == avro::AVRO_NULL) {
+            os_ << "            e.encodeNull();\n";
+        } else {
+            os_ << "            avro::encode(e, v.get_" << cppNameOf(nn)
+                << "());\n";
+        }
+        os_ << "            break;\n";
+    }
+
+    // The value is decoded in place, reusing the one held if the branch
+    // does not change.
     os_ << "        }\n"
         << "    }\n"
-        << "};\n\n";
+        << "    static void decode(Decoder& d, " << fn << "& v) {\n"
+        << "        size_t n = d.decodeUnionIndex();\n"
+        << "        if (n >= " << c << ") { throw avro::Exception(\""
+                                       "Union index too big\"); }\n"
+        << "        switch (n) {\n";
+
+    for (size_t i = 0; i < c; ++i) {
+        const NodePtr &nn = n->leafAt(i);
+        os_ << "        case " << i << ":\n";
+        if (nn->type() == avro::AVRO_NULL) {
+            os_ << "            d.decodeNull();\n"
+                << "            v.set_null();\n";
+        } else {
+            os_ << "            if (v.idx() != " << i << ") {\n"
+                << "                v.emplace_" << cppNameOf(nn) << "();\n"
+                << "            }\n"
+                << "            avro::decode(d, v.get_" << cppNameOf(nn) << "());\n";
+        }
+        os_ << "            break;\n";
+    }
+    os_ << "        }\n"
+        << "    }\n";
+    generateUnionEncodedSize(n);
+    os_ << "};\n\n";
 }
 
 void CodeGen::generateTraits(const NodePtr &n) {
@@ -681,6 +1137,957 @@ void CodeGen::generateTraits(const NodePtr &n) {
     }
 }
 
+static NodePtr resolved(const NodePtr &n) {
+    return n->type() == avro::AVRO_SYMBOLIC ? resolveSymbol(n) : n;
+}
+
+static bool isPromotable(avro::Type w, avro::Type r) {
+    switch (w) {
+        case avro::AVRO_INT:
+            return r == avro::AVRO_LONG || r == avro::AVRO_FLOAT || r == avro::AVRO_DOUBLE;
+        case avro::AVRO_LONG:
+            return r == avro::AVRO_FLOAT || r == avro::AVRO_DOUBLE;
+        case avro::AVRO_FLOAT:
+            return r == avro::AVRO_DOUBLE;
+        case avro::AVRO_STRING:
+            return r == avro::AVRO_BYTES;
+        case avro::AVRO_BYTES:
+            return r == avro::AVRO_STRING;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Returns true if data written as (non-union) \p w can be read as \p r.
+ * Both nodes must already be resolved.
+ */
+static bool resolvesTo(const NodePtr &w, const NodePtr &r) {
+    if (w->type() != r->type()) {
+        return isPromotable(w->type(), r->type());
+    }
+    switch (w->type()) {
+        case avro::AVRO_FIXED:
+            if (w->fixedSize() != r->fixedSize()) {
+                return false;
+            }
+            // fall through
+        case avro::AVRO_RECORD:
+        case avro::AVRO_ENUM:
+            return w->name().simpleName() == r->name().simpleName();
+        default:
+            return true;
+    }
+}
+
+/**
+ * Returns the branch of reader union \p r that data written as \p w is
+ * read into: the first one of the same type, failing which the first one
+ * \p w can be promoted to. Returns r->leaves() if there is none.
+ */
+static size_t readerBranch(const NodePtr &w, const NodePtr &r) {
+    size_t c = r->leaves();
+    for (size_t i = 0; i < c; ++i) {
+        const NodePtr &b = resolved(r->leafAt(i));
+        if (b->type() == w->type() && resolvesTo(w, b)) {
+            return i;
+        }
+    }
+    for (size_t i = 0; i < c; ++i) {
+        if (resolvesTo(w, resolved(r->leafAt(i)))) {
+            return i;
+        }
+    }
+    return c;
+}
+
+static string hexOf(uint64_t v) {
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << v;
+    return oss.str();
+}
+
+/**
+ * Emits, for each writer schema, a function that decodes plain binary data
+ * written with that schema straight into the types generated for the
+ * reader schema, and a decodeFrom() that picks one by fingerprint.
+ */
+void CodeGen::generateResolvedDecoders(const ValidSchema &schema,
+                                       const vector<ValidSchema> &writers) {
+    const NodePtr &root = schema.root();
+    string type = cppTypeOf(root);
+    vector<uint64_t> fingerprints;
+    for (vector<ValidSchema>::const_iterator it = writers.begin();
+         it != writers.end(); ++it) {
+        uint64_t fp = it->fingerprint();
+        if (std::find(fingerprints.begin(), fingerprints.end(), fp) != fingerprints.end()) {
+            continue;
+        }
+        fingerprints.push_back(fp);
+        resolvedSuffix_ = hexOf(fp);
+        resolvedDone_.clear();
+        skipDone_.clear();
+        resolvedDecls_.clear();
+        resolvedDefs_.clear();
+
+        std::ostringstream body;
+        generateResolvedRead(body, it->root(), root, "v", "    ", 0);
+
+        for (vector<string>::const_iterator d = resolvedDecls_.begin();
+             d != resolvedDecls_.end(); ++d) {
+            os_ << *d;
+        }
+        if (!resolvedDecls_.empty()) {
+            os_ << "\n";
+        }
+        for (vector<string>::const_iterator d = resolvedDefs_.begin();
+             d != resolvedDefs_.end(); ++d) {
+            os_ << *d;
+        }
+        os_ << "/// Decodes a " << type << " written with the writer schema whose\n"
+            << "/// fingerprint is 0x" << resolvedSuffix_ << ".\n"
+            << "inline void decodeFrom_" << resolvedSuffix_
+            << "(avro::Decoder &d, " << type << " &v) {\n"
+            << body.str()
+            << "}\n\n";
+    }
+
+    os_ << "/// Decodes a " << type << " written with the writer schema whose\n"
+        << "/// fingerprint is \\p fp. Returns false if that schema is unknown.\n"
+        << "inline bool decodeFrom(uint64_t fp, avro::Decoder &d, " << type << " &v) {\n"
+        << "    switch (fp) {\n";
+    for (vector<uint64_t>::const_iterator it = fingerprints.begin();
+         it != fingerprints.end(); ++it) {
+        string h = hexOf(*it);
+        os_ << "    case 0x" << h << "ULL:\n"
+            << "        decodeFrom_" << h << "(d, v);\n"
+            << "        return true;\n";
+    }
+    os_ << "    default:\n"
+        << "        return false;\n"
+        << "    }\n"
+        << "}\n\n";
+}
+
+string CodeGen::resolvedRecordDecoder(const NodePtr &w, const NodePtr &r) {
+    std::pair<NodePtr, NodePtr> key(w, r);
+    map<std::pair<NodePtr, NodePtr>, string>::const_iterator it = resolvedDone_.find(key);
+    if (it != resolvedDone_.end()) {
+        return it->second;
+    }
+    string fn = "decodeFrom_" + resolvedSuffix_ + "_" + lexical_cast<string>(resolvedDone_.size());
+    resolvedDone_[key] = fn;
+    string sig = "inline void " + fn + "(avro::Decoder &d, " + cppTypeOf(r) + " &v)";
+    resolvedDecls_.push_back(sig + ";\n");
+
+    std::ostringstream os;
+    os << sig << " {\n";
+    size_t c = r->leaves();
+    vector<bool> written(c, false);
+    for (size_t i = 0; i < w->leaves(); ++i) {
+        size_t j;
+        if (r->nameIndex(w->nameAt(i), j)) {
+            written[j] = true;
+            generateResolvedRead(os, w->leafAt(i), r->leafAt(j),
+                                 "v." + decorate(r->nameAt(j)), "    ", 0);
+        } else {
+            generateSkip(os, w->leafAt(i), "    ", 0);
+        }
+    }
+    for (size_t j = 0; j < c; ++j) {
+        if (written[j]) {
+            continue;
+        }
+        const avro::GenericDatum &datum = r->defaultValueAt(j);
+        if (!datum.isUnion() && datum.type() == avro::AVRO_NULL && resolved(r->leafAt(j))->type() != avro::AVRO_NULL) {
+            throw avro::Exception(boost::format("Field %1% of %2% has no default value")
+                                  % r->nameAt(j) % r->name().fullname());
+        }
+        generateDefault(os, r->leafAt(j), datum, "v." + decorate(r->nameAt(j)), "    ");
+    }
+    os << "}\n\n";
+    resolvedDefs_.push_back(os.str());
+    return fn;
+}
+
+string CodeGen::recordSkipper(const NodePtr &w) {
+    map<NodePtr, string>::const_iterator it = skipDone_.find(w);
+    if (it != skipDone_.end()) {
+        return it->second;
+    }
+    string fn = "skipFrom_" + resolvedSuffix_ + "_" + lexical_cast<string>(skipDone_.size());
+    skipDone_[w] = fn;
+    string sig = "inline void " + fn + "(avro::Decoder &d)";
+    resolvedDecls_.push_back(sig + ";\n");
+
+    std::ostringstream os;
+    os << sig << " {\n";
+    for (size_t i = 0; i < w->leaves(); ++i) {
+        generateSkip(os, w->leafAt(i), "    ", 0);
+    }
+    os << "}\n\n";
+    resolvedDefs_.push_back(os.str());
+    return fn;
+}
+
+void CodeGen::generateResolvedRead(ostream &os, const NodePtr &wn, const NodePtr &rn,
+                                   const string &target, const string &indent,
+                                   size_t depth) {
+    const NodePtr &w = resolved(wn);
+    const NodePtr &r = resolved(rn);
+    string sfx = lexical_cast<string>(depth);
+
+    if (w->type() == avro::AVRO_UNION) {
+        os << indent << "switch (d.decodeUnionIndex()) {\n";
+        for (size_t i = 0; i < w->leaves(); ++i) {
+            const NodePtr &b = resolved(w->leafAt(i));
+            os << indent << "case " << i << ":\n";
+            if (r->type() == avro::AVRO_UNION ? readerBranch(b, r) < r->leaves() : resolvesTo(b, r)) {
+                generateResolvedRead(os, b, r, target, indent + "    ", depth + 1);
+                os << indent << "    break;\n";
+            } else {
+                os << indent << "    throw avro::Exception(\"Writer branch " << i
+                   << " does not resolve to the reader's schema\");\n";
+            }
+        }
+        os << indent << "default:\n"
+           << indent << "    throw avro::Exception(\"Union index too big\");\n"
+           << indent << "}\n";
+        return;
+    }
+
+    if (r->type() == avro::AVRO_UNION) {
+        size_t j = readerBranch(w, r);
+        if (j == r->leaves()) {
+            throw avro::Exception(boost::format("%1% does not resolve to any branch of the reader's union")
+                                  % w->type());
+        }
+        const NodePtr &b = resolved(r->leafAt(j));
+        if (b->type() == avro::AVRO_NULL) {
+            os << indent << target << ".set_null();\n";
+        } else {
+            os << indent << "{\n"
+               << indent << "    " << cppTypeOf(b) << " t" << sfx << ";\n";
+            generateResolvedRead(os, w, b, "t" + sfx, indent + "    ", depth + 1);
+            os << indent << "    " << target << ".set_" << cppNameOf(b)
+               << "(std::move(t" << sfx << "));\n"
+               << indent << "}\n";
+        }
+        return;
+    }
+
+    if (!resolvesTo(w, r)) {
+        throw avro::Exception(boost::format("%1% does not resolve to %2%")
+                              % w->type() % r->type());
+    }
+
+    switch (w->type()) {
+        case avro::AVRO_NULL:
+            break;
+        case avro::AVRO_INT:
+        case avro::AVRO_LONG:
+        case avro::AVRO_FLOAT:
+            if (w->type() != r->type()) {
+                const char *m = w->type() == avro::AVRO_INT ? "decodeInt" : w->type() == avro::AVRO_LONG ? "decodeLong"
+                                                                                                         : "decodeFloat";
+                os << indent << target << " = static_cast<" << cppTypeOf(r)
+                   << ">(d." << m << "());\n";
+                break;
+            }
+            // fall through
+        case avro::AVRO_BOOL:
+        case avro::AVRO_DOUBLE:
+        case avro::AVRO_FIXED:
+            os << indent << "avro::decode(d, " << target << ");\n";
+            break;
+        case avro::AVRO_STRING:
+        case avro::AVRO_BYTES:
+            if (w->type() == r->type()) {
+                os << indent << "avro::decode(d, " << target << ");\n";
+            } else {
+                os << indent << "{\n"
+                   << indent << "    " << cppTypeOf(w) << " t" << sfx << ";\n"
+                   << indent << "    avro::decode(d, t" << sfx << ");\n"
+                   << indent << "    " << target << ".assign(t" << sfx << ".begin(), t"
+                   << sfx << ".end());\n"
+                   << indent << "}\n";
+            }
+            break;
+        case avro::AVRO_ENUM: {
+            string t = cppTypeOf(r);
+            os << indent << "switch (d.decodeEnum()) {\n";
+            for (size_t i = 0; i < w->names(); ++i) {
+                size_t j;
+                os << indent << "case " << i << ":\n";
+                if (r->nameIndex(w->nameAt(i), j)) {
+                    os << indent << "    " << target << " = " << t << "::"
+                       << decorate(r->nameAt(j)) << ";\n"
+                       << indent << "    break;\n";
+                } else {
+                    os << indent << "    throw avro::Exception(\"Symbol " << w->nameAt(i)
+                       << " is not in the reader's enum\");\n";
+                }
+            }
+            os << indent << "default:\n"
+               << indent << "    throw avro::Exception(\"Enum value too big\");\n"
+               << indent << "}\n";
+            break;
+        }
+        case avro::AVRO_ARRAY: {
+            const NodePtr &ri = resolved(r->leafAt(0));
+            string n = "n" + sfx, c = "c" + sfx, i = "i" + sfx;
+            os << indent << "{\n"
+               << indent << "    size_t " << c << " = 0;\n"
+               << indent << "    for (size_t " << n << " = d.arrayStart(); " << n
+               << " != 0; " << n << " = d.arrayNext()) {\n";
+            if (!arrayContainer_.empty()) {
+                os << indent << "        if (" << n << " > " << target << ".max_size() - " << c << ") {\n"
+                   << indent << "            throw avro::Exception(\"Too many items for array\");\n"
+                   << indent << "        }\n";
+            }
+            os << indent << "        if (" << target << ".size() < " << c << " + " << n << ") {\n"
+               << indent << "            " << target << ".resize(" << c << " + " << n << ");\n"
+               << indent << "        }\n"
+               << indent << "        for (size_t " << i << " = 0; " << i << " < " << n
+               << "; ++" << i << ", ++" << c << ") {\n";
+            if (ri->type() == avro::AVRO_BOOL) {
+                // std::vector<bool> hands out proxies, not references
+                os << indent << "            bool b" << sfx << ";\n";
+                generateResolvedRead(os, w->leafAt(0), ri, "b" + sfx, indent + "            ", depth + 1);
+                os << indent << "            " << target << "[" << c << "] = b" << sfx << ";\n";
+            } else {
+                generateResolvedRead(os, w->leafAt(0), ri, target + "[" + c + "]",
+                                     indent + "            ", depth + 1);
+            }
+            os << indent << "        }\n"
+               << indent << "    }\n"
+               << indent << "    " << target << ".resize(" << c << ");\n"
+               << indent << "}\n";
+            break;
+        }
+        case avro::AVRO_MAP: {
+            // The map's codec keeps the entries whose keys are still there
+            // and has their values decoded in place.
+            string m = "m" + sfx;
+            os << indent << "avro::codec_traits<" << cppTypeOf(r) << " >::decode(d, " << target << ",\n"
+               << indent << "    [](avro::Decoder &d, " << cppTypeOf(r->leafAt(1)) << " &" << m << ") {\n";
+            generateResolvedRead(os, w->leafAt(1), r->leafAt(1), m, indent + "        ", depth + 1);
+            os << indent << "    });\n";
+            break;
+        }
+        case avro::AVRO_RECORD:
+            os << indent << resolvedRecordDecoder(w, r) << "(d, " << target << ");\n";
+            break;
+        default:
+            throw avro::Exception(boost::format("Cannot resolve %1%") % w->type());
+    }
+}
+
+void CodeGen::generateSkip(ostream &os, const NodePtr &wn, const string &indent,
+                           size_t depth) {
+    const NodePtr &w = resolved(wn);
+    string sfx = lexical_cast<string>(depth);
+    switch (w->type()) {
+        case avro::AVRO_NULL:
+            break;
+        case avro::AVRO_BOOL:
+            os << indent << "d.decodeBool();\n";
+            break;
+        case avro::AVRO_INT:
+            os << indent << "d.decodeInt();\n";
+            break;
+        case avro::AVRO_LONG:
+            os << indent << "d.decodeLong();\n";
+            break;
+        case avro::AVRO_FLOAT:
+            os << indent << "d.decodeFloat();\n";
+            break;
+        case avro::AVRO_DOUBLE:
+            os << indent << "d.decodeDouble();\n";
+            break;
+        case avro::AVRO_STRING:
+            os << indent << "d.skipString();\n";
+            break;
+        case avro::AVRO_BYTES:
+            os << indent << "d.skipBytes();\n";
+            break;
+        case avro::AVRO_FIXED:
+            os << indent << "d.skipFixed(" << w->fixedSize() << ");\n";
+            break;
+        case avro::AVRO_ENUM:
+            os << indent << "d.decodeEnum();\n";
+            break;
+        case avro::AVRO_ARRAY:
+        case avro::AVRO_MAP: {
+            bool isArray = w->type() == avro::AVRO_ARRAY;
+            string n = "n" + sfx, i = "i" + sfx;
+            string next = isArray ? "d.skipArray()" : "d.skipMap()";
+            os << indent << "for (size_t " << n << " = " << next << "; " << n
+               << " != 0; " << n << " = " << next << ") {\n"
+               << indent << "    for (size_t " << i << " = 0; " << i << " < " << n
+               << "; ++" << i << ") {\n";
+            if (!isArray) {
+                os << indent << "        d.skipString();\n";
+            }
+            generateSkip(os, w->leafAt(isArray ? 0 : 1), indent + "        ", depth + 1);
+            os << indent << "    }\n"
+               << indent << "}\n";
+            break;
+        }
+        case avro::AVRO_UNION:
+            os << indent << "switch (d.decodeUnionIndex()) {\n";
+            for (size_t i = 0; i < w->leaves(); ++i) {
+                os << indent << "case " << i << ":\n";
+                generateSkip(os, w->leafAt(i), indent + "    ", depth + 1);
+                os << indent << "    break;\n";
+            }
+            os << indent << "default:\n"
+               << indent << "    throw avro::Exception(\"Union index too big\");\n"
+               << indent << "}\n";
+            break;
+        case avro::AVRO_RECORD:
+            if (viewSkips_) {
+                os << indent << "d.skipFixed(" << decorate(w->name()) << "_View(d.position(), d.end())"
+                   << ".encodedSize());\n";
+            } else {
+                os << indent << recordSkipper(w) << "(d);\n";
+            }
+            break;
+        default:
+            throw avro::Exception(boost::format("Cannot skip %1%") % w->type());
+    }
+}
+
+/// Emits a static array named bytes that holds the given bytes.
+static void generateByteArray(ostream &os, const vector<uint8_t> &bytes, const string &indent) {
+    os << indent << "static const uint8_t bytes[] = {";
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        os << (i % 12 == 0 ? "\n" + indent + "    " : " ")
+           << "0x" << std::hex << std::setw(2) << std::setfill('0')
+           << static_cast<unsigned>(bytes[i]) << std::dec << ',';
+    }
+    os << "\n"
+       << indent << "};\n";
+}
+
+/**
+ * Emits the assignment of a reader field's default. Scalars, strings and
+ * bytes are assigned as literals; others are decoded once from their
+ * binary encoding, computed here, and then copied.
+ */
+void CodeGen::generateDefault(ostream &os, const NodePtr &rn, const avro::GenericDatum &datum,
+                              const string &target, const string &indent) {
+    const NodePtr &r = resolved(rn);
+    switch (r->type()) {
+        case avro::AVRO_NULL:
+            return;
+        case avro::AVRO_BOOL:
+            os << indent << target << " = " << (datum.value<bool>() ? "true" : "false") << ";\n";
+            return;
+        case avro::AVRO_INT:
+            os << indent << target << " = " << datum.value<int32_t>() << ";\n";
+            return;
+        case avro::AVRO_LONG:
+            if (datum.value<int64_t>() != std::numeric_limits<int64_t>::min()) {
+                os << indent << target << " = INT64_C(" << datum.value<int64_t>() << ");\n";
+                return;
+            }
+            break;
+        case avro::AVRO_FLOAT:
+            if (std::isfinite(datum.value<float>())) {
+                os << indent << target << " = static_cast<float>("
+                   << std::setprecision(std::numeric_limits<float>::max_digits10)
+                   << datum.value<float>() << ");\n";
+                return;
+            }
+            break;
+        case avro::AVRO_DOUBLE:
+            if (std::isfinite(datum.value<double>())) {
+                os << indent << target << " = static_cast<double>("
+                   << std::setprecision(std::numeric_limits<double>::max_digits10)
+                   << datum.value<double>() << ");\n";
+                return;
+            }
+            break;
+        case avro::AVRO_ENUM:
+            os << indent << target << " = " << cppTypeOf(r) << "::"
+               << decorate(datum.value<avro::GenericEnum>().symbol()) << ";\n";
+            return;
+        case avro::AVRO_STRING: {
+            const string &v = datum.value<string>();
+            os << indent << target << ".assign(" << stringLiteral(v, indent + "    ")
+               << ", " << v.size() << ");\n";
+            return;
+        }
+        case avro::AVRO_BYTES: {
+            const vector<uint8_t> &v = datum.value<vector<uint8_t>>();
+            if (v.empty()) {
+                os << indent << target << ".clear();\n";
+                return;
+            }
+            os << indent << "{\n";
+            generateByteArray(os, v, indent + "    ");
+            os << indent << "    " << target << ".assign(bytes, bytes + sizeof(bytes));\n"
+               << indent << "}\n";
+            return;
+        }
+        default:
+            break;
+    }
+
+    std::unique_ptr<avro::OutputStream> out = avro::memoryOutputStream();
+    avro::EncoderPtr e = avro::binaryEncoder();
+    e->init(*out);
+    avro::GenericWriter::write(*e, datum);
+    e->flush();
+    avro::InputStreamPtr in = avro::memoryInputStream(*out);
+    vector<uint8_t> bytes;
+    const uint8_t *p;
+    size_t n;
+    while (in->next(&p, &n)) {
+        bytes.insert(bytes.end(), p, p + n);
+    }
+    if (bytes.empty()) {
+        return;
+    }
+
+    // Other defaults are decoded once, from their encoding, and copied.
+    // With --pmr, the copy kept lives in the new_delete_resource, as the
+    // default resource when it is made may not outlive it.
+    string t = cppTypeOf(r);
+    bool allocatorAware = pmr_ && (r->type() == avro::AVRO_RECORD || r->type() == avro::AVRO_ARRAY
+                                   || r->type() == avro::AVRO_MAP);
+    os << indent << "{\n";
+    generateByteArray(os, bytes, indent + "    ");
+    os << indent << "    static const " << t << " dflt = []() -> " << t << " {\n"
+       << indent << "        " << t << " value" << (allocatorAware ? "(std::pmr::new_delete_resource())" : "") << ";\n"
+       << indent << "        avro::InputStreamPtr in = avro::memoryInputStream(bytes, sizeof(bytes));\n"
+       << indent << "        avro::DecoderPtr dd = avro::binaryDecoder();\n"
+       << indent << "        dd->init(*in);\n"
+       << indent << "        avro::decode(*dd, value);\n"
+       << indent << "        return value;\n"
+       << indent << "    }();\n"
+       << indent << "    " << target << " = dflt;\n"
+       << indent << "}\n";
+}
+
+static void collectRecords(const NodePtr &n, vector<NodePtr> &records, set<NodePtr> &seen) {
+    if (n->type() == avro::AVRO_SYMBOLIC || !seen.insert(n).second) {
+        return;
+    }
+    for (size_t i = 0; i < n->leaves(); ++i) {
+        collectRecords(n->leafAt(i), records, seen);
+    }
+    if (n->type() == avro::AVRO_RECORD) {
+        records.push_back(n);
+    }
+}
+
+/**
+ * Emits, for every record, a read-only view over its binary encoding.
+ * A view notes where each field starts as it gets there, so a field is
+ * found by skipping only the ones before it that have not been skipped
+ * yet. Strings, bytes and fixed are returned as string_views into the
+ * data, records as views and other types are decoded on access, through
+ * a CursorDecoder on the stack.
+ */
+void CodeGen::generateViews(const NodePtr &root) {
+    vector<NodePtr> records;
+    set<NodePtr> seen;
+    collectRecords(root, records, seen);
+
+    for (vector<NodePtr>::const_iterator it = records.begin(); it != records.end(); ++it) {
+        os_ << "class " << decorate((*it)->name()) << "_View;\n";
+    }
+    os_ << "\n";
+
+    for (vector<NodePtr>::const_iterator it = records.begin(); it != records.end(); ++it) {
+        const NodePtr &n = *it;
+        string name = decorate(n->name()) + "_View";
+        size_t c = n->leaves();
+        os_ << "/// A read-only view of a " << decorate(n->name())
+            << " in its binary encoding.\n"
+            << "/// Field offsets are found lazily but published atomically, so\n"
+            << "/// const members may be called on one view from several threads.\n"
+            << "class " << name << " {\n"
+            << "    const uint8_t *end_;\n"
+            << "    mutable std::atomic<const uint8_t *> offsets_[" << c + 1 << "];\n"
+            << "    mutable std::atomic<size_t> known_;\n"
+            << "    const uint8_t *field_(size_t i) const;\n"
+            << "    void copyOffsets_(const " << name << " &o) {\n"
+            << "        size_t k = o.known_.load(std::memory_order_acquire);\n"
+            << "        for (size_t i = 0; i < k; ++i) {\n"
+            << "            offsets_[i].store(o.offsets_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);\n"
+            << "        }\n"
+            << "        known_.store(k, std::memory_order_release);\n"
+            << "    }\n"
+            << "public:\n"
+            << "    " << name << "(const uint8_t *data, const uint8_t *end) : end_(end), known_(1) {\n"
+            << "        offsets_[0].store(data, std::memory_order_relaxed);\n"
+            << "    }\n"
+            << "    " << name << "(const uint8_t *data, size_t size) : end_(data + size), known_(1) {\n"
+            << "        offsets_[0].store(data, std::memory_order_relaxed);\n"
+            << "    }\n"
+            << "    " << name << "(const " << name << " &o) : end_(o.end_), known_(0) {\n"
+            << "        copyOffsets_(o);\n"
+            << "    }\n"
+            << "    " << name << " &operator=(const " << name << " &o) {\n"
+            << "        if (this != &o) {\n"
+            << "            end_ = o.end_;\n"
+            << "            copyOffsets_(o);\n"
+            << "        }\n"
+            << "        return *this;\n"
+            << "    }\n"
+            << "    /// Returns the length of the encoded record.\n"
+            << "    size_t encodedSize() const {\n"
+            << "        return static_cast<size_t>(field_(" << c << ") - offsets_[0].load(std::memory_order_relaxed));\n"
+            << "    }\n";
+        for (size_t i = 0; i < c; ++i) {
+            const NodePtr &f = resolved(n->leafAt(i));
+            string fname = decorate(n->nameAt(i));
+            switch (f->type()) {
+                case avro::AVRO_NULL:
+                    break;
+                case avro::AVRO_STRING:
+                case avro::AVRO_BYTES:
+                case avro::AVRO_FIXED:
+                    os_ << "    avro::string_view " << fname << "() const;\n";
+                    break;
+                case avro::AVRO_RECORD:
+                    os_ << "    " << decorate(f->name()) << "_View " << fname << "() const;\n";
+                    break;
+                default:
+                    os_ << "    " << cppTypeOf(f) << " " << fname << "() const;\n";
+                    break;
+            }
+        }
+        os_ << "};\n\n";
+    }
+
+    viewSkips_ = true;
+    for (vector<NodePtr>::const_iterator it = records.begin(); it != records.end(); ++it) {
+        generateViewMembers(*it);
+    }
+    viewSkips_ = false;
+}
+
+void CodeGen::generateViewMembers(const NodePtr &n) {
+    string name = decorate(n->name()) + "_View";
+    size_t c = n->leaves();
+
+    os_ << "inline const uint8_t *" << name << "::field_(size_t i) const {\n"
+        << "    size_t k = known_.load(std::memory_order_acquire);\n"
+        << "    while (k <= i) {\n"
+        << "        avro::BinaryCursor d(offsets_[k - 1].load(std::memory_order_relaxed), end_);\n"
+        << "        switch (k - 1) {\n";
+    for (size_t i = 0; i < c; ++i) {
+        os_ << "        case " << i << ":\n";
+        generateSkip(os_, n->leafAt(i), "            ", 0);
+        os_ << "            break;\n";
+    }
+    os_ << "        }\n"
+        << "        // Another thread may store the same offset; only ever raise known_.\n"
+        << "        offsets_[k++].store(d.position(), std::memory_order_relaxed);\n"
+        << "        size_t seen = known_.load(std::memory_order_relaxed);\n"
+        << "        while (seen < k && !known_.compare_exchange_weak(seen, k, std::memory_order_release,\n"
+        << "                                                         std::memory_order_relaxed)) {\n"
+        << "        }\n"
+        << "    }\n"
+        << "    return offsets_[i].load(std::memory_order_relaxed);\n"
+        << "}\n\n";
+
+    for (size_t i = 0; i < c; ++i) {
+        const NodePtr &f = resolved(n->leafAt(i));
+        string fname = decorate(n->nameAt(i));
+        string cursor = "    avro::BinaryCursor d(field_(" + lexical_cast<string>(i) + "), end_);\n";
+        switch (f->type()) {
+            case avro::AVRO_NULL:
+                continue;
+            case avro::AVRO_BOOL:
+            case avro::AVRO_INT:
+            case avro::AVRO_LONG:
+            case avro::AVRO_FLOAT:
+            case avro::AVRO_DOUBLE: {
+                const char *m = f->type() == avro::AVRO_BOOL ? "decodeBool" : f->type() == avro::AVRO_INT ? "decodeInt"
+                                                                          : f->type() == avro::AVRO_LONG  ? "decodeLong"
+                                                                          : f->type() == avro::AVRO_FLOAT ? "decodeFloat"
+                                                                                                          : "decodeDouble";
+                os_ << "inline " << cppTypeOf(f) << " " << name << "::" << fname << "() const {\n"
+                    << cursor
+                    << "    return d." << m << "();\n";
+                break;
+            }
+            case avro::AVRO_STRING:
+            case avro::AVRO_BYTES:
+                os_ << "inline avro::string_view " << name << "::" << fname << "() const {\n"
+                    << cursor
+                    << "    return d." << (f->type() == avro::AVRO_STRING ? "decodeString" : "decodeBytes")
+                    << "();\n";
+                break;
+            case avro::AVRO_FIXED:
+                os_ << "inline avro::string_view " << name << "::" << fname << "() const {\n"
+                    << cursor
+                    << "    return d.decodeFixed(" << f->fixedSize() << ");\n";
+                break;
+            case avro::AVRO_ENUM: {
+                string fn = cppTypeOf(f);
+                os_ << "inline " << fn << " " << name << "::" << fname << "() const {\n"
+                    << cursor
+                    << "    size_t index = d.decodeEnum();\n"
+                    << "    if (index > static_cast<size_t>(" << fn << "::"
+                    << decorate(f->nameAt(f->names() - 1)) << ")) {\n"
+                    << "        std::ostringstream error;\n"
+                    << R"(        error << "enum value " << index << " is out of bound for )" << fn
+                    << " and cannot be decoded\";\n"
+                    << "        throw avro::Exception(error.str());\n"
+                    << "    }\n"
+                    << "    return static_cast<" << fn << ">(index);\n";
+                break;
+            }
+            case avro::AVRO_RECORD:
+                os_ << "inline " << decorate(f->name()) << "_View " << name << "::" << fname << "() const {\n"
+                    << "    return " << decorate(f->name()) << "_View(field_(" << i << "), end_);\n";
+                break;
+            default:
+                os_ << "inline " << cppTypeOf(f) << " " << name << "::" << fname << "() const {\n"
+                    << "    avro::CursorDecoder d(field_(" << i << "), end_);\n"
+                    << "    " << cppTypeOf(f) << " v;\n"
+                    << "    avro::decode(d, v);\n"
+                    << "    return v;\n";
+                break;
+        }
+        os_ << "}\n\n";
+    }
+}
+
+/**
+ * Returns the call of fn, one of compare and hashValue, for a value of
+ * the given type. Records and unions have overloads next to them, the
+ * others are in the library.
+ */
+string CodeGen::comparisonCall(const NodePtr &n, const string &fn, const string &args) {
+    avro::Type t = resolved(n)->type();
+    bool generated = t == avro::AVRO_RECORD || t == avro::AVRO_UNION;
+    return (generated ? "" : "avro::") + fn + "(" + args + ")";
+}
+
+string CodeGen::unionValue(const NodePtr &u, size_t i, const string &v) {
+    if (tagged.find(u) != tagged.end()) {
+        return v + ".v" + lexical_cast<string>(i) + "_";
+    }
+    return string("*") + ANY_NS + "::any_cast<" + cppTypeOf(u->leafAt(i)) + " >(&" + v + ".value_)";
+}
+
+/**
+ * Returns whether n can hold a map other than in an ignored field.
+ */
+static bool holdsMap(const NodePtr &n, set<NodePtr> &seen) {
+    const NodePtr &nn = resolved(n);
+    if (!seen.insert(nn).second) {
+        return false;
+    }
+    switch (nn->type()) {
+        case avro::AVRO_MAP:
+            return true;
+        case avro::AVRO_ARRAY:
+        case avro::AVRO_UNION:
+        case avro::AVRO_RECORD:
+            for (size_t i = 0; i < nn->leaves(); ++i) {
+                if ((nn->type() != avro::AVRO_RECORD || nn->fieldOrderAt(i) != avro::ORDER_IGNORE)
+                    && holdsMap(nn->leafAt(i), seen)) {
+                    return true;
+                }
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Returns whether values of n have an Avro sort order. Maps have none, so
+ * neither has anything holding a map other than in an ignored field.
+ */
+bool CodeGen::hasOrder(const NodePtr &n) {
+    const NodePtr &nn = resolved(n);
+    map<NodePtr, bool>::const_iterator it = ordered_.find(nn);
+    if (it != ordered_.end()) {
+        return it->second;
+    }
+    set<NodePtr> seen;
+    bool result = !holdsMap(nn, seen);
+    ordered_[nn] = result;
+    return result;
+}
+
+void CodeGen::generateFriendComparisons(const NodePtr &n, const string &name) {
+    os_ << "    friend bool operator==(const " << name << " &a, const " << name << " &b);\n";
+    if (hasOrder(n)) {
+        os_ << "    friend int compare(const " << name << " &a, const " << name << " &b);\n";
+    }
+    os_ << "    friend size_t hashValue(const " << name << " &v);\n";
+}
+
+/**
+ * Emits operator==, compare() and hashValue() for the generated records
+ * and unions, declaring them all first as they may refer to each other.
+ * Records compare field by field in the order of the Avro specification;
+ * fields with "order": "descending" reverse the result and those with
+ * "order": "ignore" take no part in comparison, equality or hashing, so
+ * that the three agree. Enums and fixed are handled by the library.
+ * compare() is left out for types that hold a map, which has no order,
+ * so that comparing them fails to compile rather than throws.
+ */
+void CodeGen::generateComparisons() {
+    for (vector<std::pair<NodePtr, string>>::const_iterator it = comparable_.begin();
+         it != comparable_.end(); ++it) {
+        if (it->first->type() == avro::AVRO_ENUM) {
+            continue;
+        }
+        const string &name = it->second;
+        os_ << "bool operator==(const " << name << " &a, const " << name << " &b);\n";
+        if (hasOrder(it->first)) {
+            os_ << "int compare(const " << name << " &a, const " << name << " &b);\n";
+        } else {
+            os_ << "// No compare() for " << name << ": Avro maps have no order.\n";
+        }
+        os_ << "size_t hashValue(const " << name << " &v);\n";
+    }
+    os_ << "\n";
+    for (vector<std::pair<NodePtr, string>>::const_iterator it = comparable_.begin();
+         it != comparable_.end(); ++it) {
+        if (it->first->type() == avro::AVRO_RECORD) {
+            generateRecordComparisons(it->first, it->second);
+        } else if (it->first->type() == avro::AVRO_UNION) {
+            generateUnionComparisons(it->first, it->second);
+        } else {
+            continue;
+        }
+        const string &name = it->second;
+        os_ << "inline bool operator!=(const " << name << " &a, const " << name << " &b) {\n"
+            << "    return !(a == b);\n"
+            << "}\n\n";
+    }
+}
+
+void CodeGen::generateRecordComparisons(const NodePtr &n, const string &name) {
+    vector<size_t> fields;
+    for (size_t i = 0; i < n->leaves(); ++i) {
+        if (n->fieldOrderAt(i) != avro::ORDER_IGNORE && resolved(n->leafAt(i))->type() != avro::AVRO_NULL) {
+            fields.push_back(i);
+        }
+    }
+    const string a = fields.empty() ? " &" : " &a";
+    const string b = fields.empty() ? " &" : " &b";
+
+    os_ << "inline bool operator==(const " << name << a << ", const " << name << b << ") {\n"
+        << "    return ";
+    for (size_t k = 0; k < fields.size(); ++k) {
+        string f = decorate(n->nameAt(fields[k]));
+        os_ << (k == 0 ? "" : " &&\n        ") << "a." << f << " == b." << f;
+    }
+    os_ << (fields.empty() ? "true" : "") << ";\n"
+        << "}\n\n";
+
+    if (hasOrder(n)) {
+        os_ << "inline int compare(const " << name << a << ", const " << name << b << ") {\n";
+        if (!fields.empty()) {
+            os_ << "    int r;\n";
+        }
+        for (size_t i : fields) {
+            string f = decorate(n->nameAt(i));
+            os_ << "    if ((r = " << comparisonCall(n->leafAt(i), "compare", "a." + f + ", b." + f) << ") != 0) {\n"
+                << "        return " << (n->fieldOrderAt(i) == avro::ORDER_DESCENDING ? "-r" : "r") << ";\n"
+                << "    }\n";
+        }
+        os_ << "    return 0;\n"
+            << "}\n\n";
+    }
+
+    os_ << "inline size_t hashValue(const " << name << (fields.empty() ? " &" : " &v") << ") {\n"
+        << "    size_t h = 0;\n";
+    for (size_t i : fields) {
+        os_ << "    avro::hashCombine(h, "
+            << comparisonCall(n->leafAt(i), "hashValue", "v." + decorate(n->nameAt(i))) << ");\n";
+    }
+    os_ << "    return h;\n"
+        << "}\n\n";
+}
+
+/**
+ * Unions sort first by branch and then by the value of the branch.
+ */
+void CodeGen::generateUnionComparisons(const NodePtr &n, const string &name) {
+    vector<size_t> values;
+    for (size_t i = 0; i < n->leaves(); ++i) {
+        if (resolved(n->leafAt(i))->type() != avro::AVRO_NULL) {
+            values.push_back(i);
+        }
+    }
+
+    os_ << "inline bool operator==(const " << name << " &a, const " << name << " &b) {\n"
+        << "    if (a.idx_ != b.idx_) {\n"
+        << "        return false;\n"
+        << "    }\n"
+        << "    switch (a.idx_) {\n";
+    for (size_t i : values) {
+        os_ << "    case " << i << ":\n"
+            << "        return " << unionValue(n, i, "a") << " == " << unionValue(n, i, "b") << ";\n";
+    }
+    os_ << "    default:\n"
+        << "        return true;\n"
+        << "    }\n"
+        << "}\n\n";
+
+    if (hasOrder(n)) {
+        os_ << "inline int compare(const " << name << " &a, const " << name << " &b) {\n"
+            << "    if (a.idx_ != b.idx_) {\n"
+            << "        return a.idx_ < b.idx_ ? -1 : 1;\n"
+            << "    }\n"
+            << "    switch (a.idx_) {\n";
+        for (size_t i : values) {
+            os_ << "    case " << i << ":\n"
+                << "        return "
+                << comparisonCall(n->leafAt(i), "compare", unionValue(n, i, "a") + ", " + unionValue(n, i, "b"))
+                << ";\n";
+        }
+        os_ << "    default:\n"
+            << "        return 0;\n"
+            << "    }\n"
+            << "}\n\n";
+    }
+
+    os_ << "inline size_t hashValue(const " << name << " &v) {\n"
+        << "    size_t h = v.idx_;\n"
+        << "    switch (v.idx_) {\n";
+    for (size_t i : values) {
+        os_ << "    case " << i << ":\n"
+            << "        avro::hashCombine(h, " << comparisonCall(n->leafAt(i), "hashValue", unionValue(n, i, "v"))
+            << ");\n"
+            << "        break;\n";
+    }
+    os_ << "    default:\n"
+        << "        break;\n"
+        << "    }\n"
+        << "    return h;\n"
+        << "}\n\n";
+}
+
+void CodeGen::generateHashSpecializations() {
+    os_ << "namespace std {\n";
+    for (vector<std::pair<NodePtr, string>>::const_iterator it = comparable_.begin();
+         it != comparable_.end(); ++it) {
+        string fn = fullname(it->second);
+        os_ << "template<> struct hash<" << fn << "> {\n"
+            << "    size_t operator()(const " << fn << " &v) const {\n"
+            << "        return " << (it->first->type() == avro::AVRO_ENUM ? "avro::hashValue" : fullname("hashValue"))
+            << "(v);\n"
+            << "    }\n"
+            << "};\n";
+    }
+    os_ << "}\n";
+}
+
 void CodeGen::emitCopyright() {
     os_ << "/**\n"
            " * Licensed to the Apache Software Foundation (ASF) under one\n"
@@ -711,7 +2118,8 @@ string CodeGen::guard() {
     return h + "_" + lexical_cast<string>(random_()) + "__H_";
 }
 
-void CodeGen::generate(const ValidSchema &schema) {
+void CodeGen::generate(const ValidSchema &schema,
+                       const vector<ValidSchema> &writers) {
     emitCopyright();
 
     string h = guardString_.empty() ? guard() : guardString_;
@@ -719,16 +2127,40 @@ void CodeGen::generate(const ValidSchema &schema) {
     os_ << "#ifndef " << h << "\n";
     os_ << "#define " << h << "\n\n\n";
 
+    root_ = schema.root();
+    schemaJson_ = schema.toJson(false);
+    canonicalJson_ = schema.toCanonicalJson();
+    fingerprint_ = schema.fingerprint();
+
     os_ << "#include <sstream>\n"
 #if __cplusplus >= 201703L
         << "#include <any>\n"
 #else
         << "#include \"boost/any.hpp\"\n"
 #endif
+        << (taggedUnions_ ? "#include <new>\n#include <type_traits>\n#include <utility>\n" : "")
+        << (views_ ? "#include <atomic>\n" : "")
+        << (pmr_ ? "#include <memory_resource>\n" : "")
+        << (compare_ ? "#include <functional>\n" : "")
+        << (mapContainer_ == "unordered_map" ? "#include <unordered_map>\n" : "")
+        << "#include \"" << includePrefix_ << "Compiler.hh\"\n"
         << "#include \"" << includePrefix_ << "Specific.hh\"\n"
         << "#include \"" << includePrefix_ << "Encoder.hh\"\n"
         << "#include \"" << includePrefix_ << "Decoder.hh\"\n"
-        << "\n";
+        << "#include \"" << includePrefix_ << "ValidSchema.hh\"\n";
+    if (views_) {
+        os_ << "#include \"" << includePrefix_ << "BinaryCursor.hh\"\n";
+    }
+    if (compare_) {
+        os_ << "#include \"" << includePrefix_ << "Compare.hh\"\n";
+    }
+    if (!arrayContainer_.empty()) {
+        os_ << "#include \"" << includePrefix_ << "SpecificContainers.hh\"\n";
+    }
+    if (views_ || !writers.empty()) {
+        os_ << "#include \"" << includePrefix_ << "Stream.hh\"\n";
+    }
+    os_ << "\n";
 
     vector<string> nsVector;
     if (!ns_.empty()) {
@@ -758,6 +2190,10 @@ void CodeGen::generate(const ValidSchema &schema) {
                             it->initMember, it->memberName);
     }
 
+    if (compare_) {
+        generateComparisons();
+    }
+
     if (!ns_.empty()) {
         inNamespace_ = false;
         for (vector<string>::const_iterator it =
@@ -767,6 +2203,10 @@ void CodeGen::generate(const ValidSchema &schema) {
         }
     }
 
+    if (compare_) {
+        generateHashSpecializations();
+    }
+
     os_ << "namespace avro {\n";
 
     unionNumber_ = 0;
@@ -775,6 +2215,27 @@ void CodeGen::generate(const ValidSchema &schema) {
 
     os_ << "}\n";
 
+    if (views_ || !writers.empty()) {
+        for (vector<string>::const_iterator it =
+                 nsVector.begin();
+             it != nsVector.end(); ++it) {
+            os_ << "namespace " << *it << " {\n";
+        }
+        inNamespace_ = !ns_.empty();
+        if (views_) {
+            generateViews(root);
+        }
+        if (!writers.empty()) {
+            generateResolvedDecoders(schema, writers);
+        }
+        inNamespace_ = false;
+        for (vector<string>::const_iterator it =
+                 nsVector.begin();
+             it != nsVector.end(); ++it) {
+            os_ << "}\n";
+        }
+    }
+
     os_ << "#endif\n";
     os_.flush();
 }
@@ -808,10 +2269,18 @@ int main(int argc, char **argv) {
     const string IN("input");
     const string INCLUDE_PREFIX("include-prefix");
     const string NO_UNION_TYPEDEF("no-union-typedef");
+    const string TAGGED_UNIONS("tagged-unions");
+    const string WRITER_SCHEMA("writer-schema");
+    const string VIEWS("views");
+    const string PMR("pmr");
+    const string COMPARE("compare");
+    const string MAP_TYPE("map-type");
+    const string SMALL_ARRAYS("small-arrays");
+    const string STATIC_ARRAYS("static-arrays");
 
     po::options_description desc("Allowed options");
     desc.add_options()("help,h", "produce help message")("include-prefix,p", po::value<string>()->default_value("avro"),
-                                                         "prefix for include headers, - for none, default: avro")("no-union-typedef,U", "do not generate typedefs for unions in records")("namespace,n", po::value<string>(), "set namespace for generated code")("input,i", po::value<string>(), "input file")("output,o", po::value<string>(), "output file to generate");
+                                                         "prefix for include headers, - for none, default: avro")("no-union-typedef,U", "do not generate typedefs for unions in records")("tagged-unions,T", "hold union values inline instead of in an any")("views,V", "generate read-only views that decode records lazily from their binary encoding")("pmr", "use std::pmr containers and make records allocator-aware (C++17)")("compare,C", "generate operator==, compare() and std::hash following the Avro sort order")("map-type", po::value<string>()->default_value("map"), "container for Avro maps: map, unordered_map or flat (a vector of pairs)")("small-arrays", po::value<size_t>(), "hold Avro arrays in boost::container::small_vector with the given inline capacity")("static-arrays", po::value<size_t>(), "hold Avro arrays in boost::container::static_vector with the given capacity")("writer-schema,w", po::value<vector<string>>(), "writer schema to generate a resolving decoder for, may be repeated")("namespace,n", po::value<string>(), "set namespace for generated code")("input,i", po::value<string>(), "input file")("output,o", po::value<string>(), "output file to generate");
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -827,6 +2296,33 @@ int main(int argc, char **argv) {
     string inf = vm.count(IN) > 0 ? vm[IN].as<string>() : string();
     string incPrefix = vm[INCLUDE_PREFIX].as<string>();
     bool noUnion = vm.count(NO_UNION_TYPEDEF) != 0;
+    bool taggedUnions = vm.count(TAGGED_UNIONS) != 0;
+    bool views = vm.count(VIEWS) != 0;
+    bool pmr = vm.count(PMR) != 0;
+    bool compare = vm.count(COMPARE) != 0;
+    string mapContainer = vm[MAP_TYPE].as<string>();
+    bool smallArrays = vm.count(SMALL_ARRAYS) != 0;
+    bool staticArrays = vm.count(STATIC_ARRAYS) != 0;
+    string arrayContainer;
+    size_t arrayCapacity = 0;
+    if (smallArrays) {
+        arrayContainer = "boost::container::small_vector";
+        arrayCapacity = vm[SMALL_ARRAYS].as<size_t>();
+    } else if (staticArrays) {
+        arrayContainer = "boost::container::static_vector";
+        arrayCapacity = vm[STATIC_ARRAYS].as<size_t>();
+    }
+    if (mapContainer != "map" && mapContainer != "unordered_map" && mapContainer != "flat") {
+        std::cerr << "Unknown map type: " << mapContainer << std::endl;
+        return 1;
+    }
+    if ((smallArrays || staticArrays) && (arrayCapacity == 0 || (smallArrays && staticArrays) || pmr)) {
+        std::cerr << "--small-arrays and --static-arrays need a positive capacity "
+                     "and cannot be combined with each other or with --pmr"
+                  << std::endl;
+        return 1;
+    }
+    vector<string> writerFiles = vm.count(WRITER_SCHEMA) > 0 ? vm[WRITER_SCHEMA].as<vector<string>>() : vector<string>();
     if (incPrefix == "-") {
         incPrefix.clear();
     } else if (*incPrefix.rbegin() != '/') {
@@ -843,12 +2339,20 @@ int main(int argc, char **argv) {
             compileJsonSchema(std::cin, schema);
         }
 
+        vector<ValidSchema> writers(writerFiles.size());
+        for (size_t i = 0; i < writerFiles.size(); ++i) {
+            ifstream in(writerFiles[i].c_str());
+            compileJsonSchema(in, writers[i]);
+        }
+
         if (!outf.empty()) {
             string g = readGuard(outf);
             ofstream out(outf.c_str());
-            CodeGen(out, ns, inf, outf, g, incPrefix, noUnion).generate(schema);
+            CodeGen(out, ns, inf, outf, g, incPrefix, noUnion, taggedUnions, views, pmr, compare,
+                    mapContainer, arrayContainer, arrayCapacity).generate(schema, writers);
         } else {
-            CodeGen(std::cout, ns, inf, outf, "", incPrefix, noUnion).generate(schema);
+            CodeGen(std::cout, ns, inf, outf, "", incPrefix, noUnion, taggedUnions, views, pmr, compare,
+                    mapContainer, arrayContainer, arrayCapacity).generate(schema, writers);
         }
         return 0;
     } catch (std::exception &e) {
@@ -476,6 +476,7 @@ class JsonEncoder : public Encoder {
     void encodeFloat(float f) final;
     void encodeDouble(double d) final;
     void encodeString(const std::string &s) final;
+    void encodeString(const char *s, size_t len) final;
     void encodeBytes(const uint8_t *bytes, size_t len) final;
     void encodeFixed(const uint8_t *bytes, size_t len) final;
     void encodeEnum(size_t e) final;
@@ -566,6 +567,11 @@ void JsonEncoder<P, F>::encodeString(const std::string &s) {
     out_.encodeString(s);
 }
 
+template<typename P, typename F>
+void JsonEncoder<P, F>::encodeString(const char *s, size_t len) {
+    encodeString(std::string(s, len));
+}
+
 template<typename P, typename F>
 void JsonEncoder<P, F>::encodeBytes(const uint8_t *bytes, size_t len) {
     parser_.advance(Symbol::Kind::Bytes);
@@ -48,7 +48,6 @@ using std::make_pair;
 using std::map;
 using std::ostringstream;
 using std::pair;
-using std::reverse;
 using std::stack;
 using std::string;
 using std::unique_ptr;
@@ -57,6 +56,8 @@ using std::vector;
 typedef pair<NodePtr, NodePtr> NodePair;
 
 class ResolvingGrammarGenerator : public ValidatingGrammarGenerator {
+    const bool rawSkips_;
+
     ProductionPtr doGenerate2(const NodePtr &writer,
                               const NodePtr &reader, map<NodePair, ProductionPtr> &m,
                               map<NodePtr, ProductionPtr> &m2);
@@ -78,10 +79,22 @@ class ResolvingGrammarGenerator : public ValidatingGrammarGenerator {
 
     static int bestBranch(const NodePtr &writer, const NodePtr &reader);
 
+    void appendSkipAction(SkipPlan &plan, const NodePtr &writer,
+                          map<NodePtr, ProductionPtr> &m2);
+
+    static void appendRawSkip(SkipPlan &plan, size_t n);
+
     ProductionPtr getWriterProduction(const NodePtr &n,
                                       map<NodePtr, ProductionPtr> &m2);
 
 public:
+    /**
+     * If \p rawSkips is true, the grammar is meant for a decoder that
+     * reads the binary encoding and fixed-width values that are to be
+     * skipped are merged into byte spans.
+     */
+    explicit ResolvingGrammarGenerator(bool rawSkips) : rawSkips_(rawSkips) {}
+
     Symbol generate(
         const ValidSchema &writer, const ValidSchema &reader);
 };
@@ -154,6 +167,50 @@ static shared_ptr<vector<uint8_t>> getAvroBinary(
     return snapshot(*os);
 }
 
+/**
+ * Returns the default value \p d of a reader's field of type \p n if it can
+ * be handed to the reader without decoding, or null if it cannot.
+ */
+static DefaultValuePtr makeDefaultValue(const NodePtr &n, const GenericDatum &d) {
+    shared_ptr<DefaultValue> result;
+    switch (n->type()) {
+        case AVRO_NULL:
+            result = make_shared<DefaultValue>(Symbol::Kind::Null);
+            break;
+        case AVRO_BOOL:
+            result = make_shared<DefaultValue>(Symbol::Kind::Bool);
+            result->boolValue = d.value<bool>();
+            break;
+        case AVRO_INT:
+            result = make_shared<DefaultValue>(Symbol::Kind::Int);
+            result->longValue = d.value<int32_t>();
+            break;
+        case AVRO_LONG:
+            result = make_shared<DefaultValue>(Symbol::Kind::Long);
+            result->longValue = d.value<int64_t>();
+            break;
+        case AVRO_FLOAT:
+            result = make_shared<DefaultValue>(Symbol::Kind::Float);
+            result->floatValue = d.value<float>();
+            break;
+        case AVRO_DOUBLE:
+            result = make_shared<DefaultValue>(Symbol::Kind::Double);
+            result->doubleValue = d.value<double>();
+            break;
+        case AVRO_STRING:
+            result = make_shared<DefaultValue>(Symbol::Kind::String);
+            result->stringValue = d.value<string>();
+            break;
+        case AVRO_BYTES:
+            result = make_shared<DefaultValue>(Symbol::Kind::Bytes);
+            result->bytesValue = d.value<vector<uint8_t>>();
+            break;
+        default:
+            break;
+    }
+    return result;
+}
+
 template<typename T1, typename T2>
 struct equalsFirst {
     const T1 &v_;
@@ -176,11 +233,121 @@ ProductionPtr ResolvingGrammarGenerator::getWriterProduction(
     }
 }
 
+void ResolvingGrammarGenerator::appendRawSkip(SkipPlan &plan, size_t n) {
+    if (!plan.empty() && plan.back().kind == SkipAction::Kind::Fixed) {
+        plan.back().size += n;
+    } else {
+        plan.emplace_back(SkipAction::Kind::Fixed, n);
+    }
+}
+
+void ResolvingGrammarGenerator::appendSkipAction(
+    SkipPlan &plan, const NodePtr &writer, map<NodePtr, ProductionPtr> &m2) {
+    const NodePtr &n = (writer->type() == AVRO_SYMBOLIC) ? resolveSymbol(writer) : writer;
+    if (rawSkips_) {
+        switch (n->type()) {
+            case AVRO_NULL:
+                return;
+            case AVRO_BOOL:
+                appendRawSkip(plan, 1);
+                return;
+            case AVRO_FLOAT:
+                appendRawSkip(plan, 4);
+                return;
+            case AVRO_DOUBLE:
+                appendRawSkip(plan, 8);
+                return;
+            case AVRO_FIXED:
+                appendRawSkip(plan, n->fixedSize());
+                return;
+            default:
+                break;
+        }
+    }
+    switch (n->type()) {
+        case AVRO_NULL:
+            plan.emplace_back(SkipAction::Kind::Null);
+            return;
+        case AVRO_BOOL:
+            plan.emplace_back(SkipAction::Kind::Bool);
+            return;
+        case AVRO_INT:
+            plan.emplace_back(SkipAction::Kind::Int);
+            return;
+        case AVRO_LONG:
+            plan.emplace_back(SkipAction::Kind::Long);
+            return;
+        case AVRO_FLOAT:
+            plan.emplace_back(SkipAction::Kind::Float);
+            return;
+        case AVRO_DOUBLE:
+            plan.emplace_back(SkipAction::Kind::Double);
+            return;
+        case AVRO_STRING:
+            plan.emplace_back(SkipAction::Kind::String);
+            return;
+        case AVRO_BYTES:
+            plan.emplace_back(SkipAction::Kind::Bytes);
+            return;
+        case AVRO_FIXED:
+            plan.emplace_back(SkipAction::Kind::Fixed, n->fixedSize());
+            return;
+        case AVRO_ENUM:
+            plan.emplace_back(SkipAction::Kind::Enum);
+            return;
+        case AVRO_RECORD:
+            /*
+             * A record cannot contain itself other than through a union,
+             * an array or a map, none of which are flattened. So this
+             * recursion always terminates.
+             */
+            for (size_t i = 0; i < n->leaves(); ++i) {
+                appendSkipAction(plan, n->leafAt(i), m2);
+            }
+            return;
+        default:
+            break;
+    }
+    ProductionPtr p = getWriterProduction(writer, m2);
+    if (p->size() == 1) {
+        plan.emplace_back((*p)[0]);
+    } else {
+        plan.emplace_back(Symbol::indirect(p));
+    }
+}
+
+/**
+ * Returns the plan action that resolves a field through the production p.
+ */
+static PlanAction planAction(const ProductionPtr &p) {
+    if (p->size() != 1) {
+        return PlanAction(Symbol::indirect(p));
+    }
+    const Symbol &s = (*p)[0];
+    switch (s.kind()) {
+        case Symbol::Kind::Null:
+        case Symbol::Kind::Bool:
+        case Symbol::Kind::Int:
+        case Symbol::Kind::Long:
+        case Symbol::Kind::Float:
+        case Symbol::Kind::Double:
+        case Symbol::Kind::String:
+        case Symbol::Kind::Bytes:
+            return PlanAction(PlanAction::Kind::Read, s.kind(), s.kind());
+        case Symbol::Kind::Resolve: {
+            const auto *k = s.extrap<pair<Symbol::Kind, Symbol::Kind>>();
+            return PlanAction(PlanAction::Kind::Promote, k->first, k->second);
+        }
+        default:
+            return PlanAction(s);
+    }
+}
+
 ProductionPtr ResolvingGrammarGenerator::resolveRecords(
     const NodePtr &writer, const NodePtr &reader,
     map<NodePair, ProductionPtr> &m,
     map<NodePtr, ProductionPtr> &m2) {
-    ProductionPtr result = make_shared<Production>();
+    RecordPlanPtr plan = make_shared<RecordPlan>();
 
     vector<pair<string, size_t>> wf = fields(writer);
     vector<pair<string, size_t>> rf = fields(reader);
@@ -191,33 +358,34 @@ ProductionPtr ResolvingGrammarGenerator::resolveRecords(
      * We look for all writer fields in the reader. If found, recursively
      * resolve the corresponding fields. Then erase the reader field.
      * If no matching field is found for reader, arrange to skip the writer
-     * field.
+     * field. Consecutive skipped writer fields share a single skip plan so
+     * that they are consumed in one go.
      */
+    SkipPlanPtr skips;
     for (vector<pair<string, size_t>>::const_iterator it = wf.begin();
          it != wf.end(); ++it) {
         auto it2 = find_if(rf.begin(), rf.end(),
                            equalsFirst<string, size_t>(it->first));
         if (it2 != rf.end()) {
+            skips.reset();
             ProductionPtr p = doGenerate2(writer->leafAt(it->second),
                                           reader->leafAt(it2->second), m, m2);
-            copy(p->rbegin(), p->rend(), back_inserter(*result));
+            plan->push_back(planAction(p));
             fieldOrder.push_back(it2->second);
             rf.erase(it2);
         } else {
-            ProductionPtr p = getWriterProduction(
-                writer->leafAt(it->second), m2);
-            result->push_back(Symbol::skipStart());
-            if (p->size() == 1) {
-                result->push_back((*p)[0]);
-            } else {
-                result->push_back(Symbol::indirect(p));
+            if (!skips) {
+                skips = make_shared<SkipPlan>();
+                plan->emplace_back(skips);
             }
+            appendSkipAction(*skips, writer->leafAt(it->second), m2);
         }
     }
 
     /*
      * Examine the reader fields left out, (i.e. those didn't have corresponding
-     * writer field).
+     * writer field). Defaults of primitive types are handed out as they are;
+     * the others are encoded once here and decoded from those bytes each time.
      */
     for (vector<pair<string, size_t>>::const_iterator it = rf.begin();
          it != rf.end(); ++it) {
@@ -228,19 +396,26 @@ ProductionPtr ResolvingGrammarGenerator::resolveRecords(
         if (s->type() == AVRO_SYMBOLIC) {
             s = resolveSymbol(s);
         }
-        shared_ptr<vector<uint8_t>> defaultBinary =
-            getAvroBinary(reader->defaultValueAt(it->second));
-        result->push_back(Symbol::defaultStartAction(defaultBinary));
+        const GenericDatum &defaultValue = reader->defaultValueAt(it->second);
+        if (DefaultValuePtr v = makeDefaultValue(s, defaultValue)) {
+            plan->emplace_back(v);
+            continue;
+        }
+        shared_ptr<vector<uint8_t>> defaultBinary = getAvroBinary(defaultValue);
         map<NodePair, shared_ptr<Production>>::const_iterator it2 =
             m.find(NodePair(s, s));
         ProductionPtr p = (it2 == m.end()) ? doGenerate2(s, s, m, m2) : it2->second;
-        copy(p->rbegin(), p->rend(), back_inserter(*result));
-        result->push_back(Symbol::defaultEndAction());
+        ProductionPtr d = make_shared<Production>();
+        d->push_back(Symbol::defaultEndAction());
+        copy(p->begin(), p->end(), back_inserter(*d));
+        d->push_back(Symbol::defaultStartAction(defaultBinary));
+        plan->emplace_back(Symbol::indirect(d));
     }
-    reverse(result->begin(), result->end());
+
+    ProductionPtr result = make_shared<Production>();
+    result->push_back(Symbol::recordPlan(plan));
     result->push_back(Symbol::sizeListAction(fieldOrder));
     result->push_back(Symbol::recordAction());
-
     return result;
 }
 
@@ -416,30 +591,71 @@ ProductionPtr ResolvingGrammarGenerator::doGenerate2(
     return make_shared<Production>(1, Symbol::error(writer, reader));
 }
 
+/**
+ * An input stream over the encoded bytes of a default value. It is pointed
+ * at a different default each time rather than built afresh.
+ */
+class DefaultInputStream : public InputStream {
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+    size_t curLen_ = 0;
+
+public:
+    void reset(const vector<uint8_t> &data) {
+        data_ = data.data();
+        size_ = data.size();
+        curLen_ = 0;
+    }
+
+    bool next(const uint8_t **data, size_t *len) final {
+        if (curLen_ == size_) {
+            return false;
+        }
+        *data = &data_[curLen_];
+        *len = size_ - curLen_;
+        curLen_ = size_;
+        return true;
+    }
+
+    void backup(size_t len) final {
+        curLen_ -= len;
+    }
+
+    void skip(size_t len) final {
+        if (len > (size_ - curLen_)) {
+            len = size_ - curLen_;
+        }
+        curLen_ += len;
+    }
+
+    size_t byteCount() const final {
+        return curLen_;
+    }
+};
+
 class ResolvingDecoderHandler {
-    shared_ptr<vector<uint8_t>> defaultData_;
-    unique_ptr<InputStream> inp_;
-    DecoderPtr backup_;
-    DecoderPtr &base_;
+    DefaultInputStream inp_;
+    Decoder *backup_;
+    Decoder *&decoder_;
     const DecoderPtr binDecoder;
 
 public:
-    explicit ResolvingDecoderHandler(DecoderPtr &base) : base_(base),
-                                                         binDecoder(binaryDecoder()) {}
+    explicit ResolvingDecoderHandler(Decoder *&decoder) : backup_(nullptr),
+                                                          decoder_(decoder),
+                                                          binDecoder(binaryDecoder()) {}
     size_t handle(const Symbol &s) {
         switch (s.kind()) {
             case Symbol::Kind::WriterUnion:
-                return base_->decodeUnionIndex();
+                return decoder_->decodeUnionIndex();
             case Symbol::Kind::DefaultStart:
-                defaultData_ = s.extra<shared_ptr<vector<uint8_t>>>();
-                backup_ = base_;
-                inp_ = memoryInputStream(&(*defaultData_)[0], defaultData_->size());
-                base_ = binDecoder;
-                base_->init(*inp_);
+                inp_.reset(**s.extrap<shared_ptr<vector<uint8_t>>>());
+                backup_ = decoder_;
+                decoder_ = binDecoder.get();
+                decoder_->init(inp_);
                 return 0;
             case Symbol::Kind::DefaultEnd:
-                base_ = backup_;
-                backup_.reset();
+                decoder_ = backup_;
+                backup_ = nullptr;
                 return 0;
             default:
                 return 0;
@@ -448,15 +664,18 @@ public:
 
     void reset() {
         if (backup_ != nullptr) {
-            base_ = backup_;
-            backup_.reset();
+            decoder_ = backup_;
+            backup_ = nullptr;
         }
     }
 };
 
 template<typename Parser>
 class ResolvingDecoderImpl : public ResolvingDecoder {
-    DecoderPtr base_;
+    const DecoderPtr base_;
+    // The decoder the values come from: base_, or the one over the bytes
+    // of a default value.
+    Decoder *decoder_;
     ResolvingDecoderHandler handler_;
     Parser parser_;
 
@@ -484,14 +703,15 @@ class ResolvingDecoderImpl : public ResolvingDecoder {
     const vector<size_t> &fieldOrder() final;
     void drain() final {
         parser_.processImplicitActions();
-        base_->drain();
+        decoder_->drain();
     }
 
 public:
     ResolvingDecoderImpl(const ValidSchema &writer, const ValidSchema &reader,
                          DecoderPtr base) : base_(std::move(base)),
-                                            handler_(base_),
-                                            parser_(ResolvingGrammarGenerator().generate(writer, reader),
+                                            decoder_(base_.get()),
+                                            handler_(decoder_),
+                                            parser_(ResolvingGrammarGenerator(base_->isBinary()).generate(writer, reader),
                                                     &(*base_), handler_) {
     }
 };
@@ -499,95 +719,117 @@ public:
 template<typename P>
 void ResolvingDecoderImpl<P>::init(InputStream &is) {
     handler_.reset();
-    base_->init(is);
+    decoder_->init(is);
     parser_.reset();
 }
 
 template<typename P>
 void ResolvingDecoderImpl<P>::decodeNull() {
-    parser_.advance(Symbol::Kind::Null);
-    base_->decodeNull();
+    if (parser_.advance(Symbol::Kind::Null) != Symbol::Kind::DefaultValue) {
+        decoder_->decodeNull();
+    }
 }
 
 template<typename P>
 bool ResolvingDecoderImpl<P>::decodeBool() {
-    parser_.advance(Symbol::Kind::Bool);
-    return base_->decodeBool();
+    if (parser_.advance(Symbol::Kind::Bool) == Symbol::Kind::DefaultValue) {
+        return parser_.defaultValue().boolValue;
+    }
+    return decoder_->decodeBool();
 }
 
 template<typename P>
 int32_t ResolvingDecoderImpl<P>::decodeInt() {
-    parser_.advance(Symbol::Kind::Int);
-    return base_->decodeInt();
+    if (parser_.advance(Symbol::Kind::Int) == Symbol::Kind::DefaultValue) {
+        return static_cast<int32_t>(parser_.defaultValue().longValue);
+    }
+    return decoder_->decodeInt();
 }
 
 template<typename P>
 int64_t ResolvingDecoderImpl<P>::decodeLong() {
     Symbol::Kind k = parser_.advance(Symbol::Kind::Long);
-    return k == Symbol::Kind::Int ? base_->decodeInt() : base_->decodeLong();
+    if (k == Symbol::Kind::DefaultValue) {
+        return parser_.defaultValue().longValue;
+    }
+    return k == Symbol::Kind::Int ? decoder_->decodeInt() : decoder_->decodeLong();
 }
 
 template<typename P>
 float ResolvingDecoderImpl<P>::decodeFloat() {
     Symbol::Kind k = parser_.advance(Symbol::Kind::Float);
-    return k == Symbol::Kind::Int ? base_->decodeInt() : k == Symbol::Kind::Long ? base_->decodeLong() : base_->decodeFloat();
+    if (k == Symbol::Kind::DefaultValue) {
+        return parser_.defaultValue().floatValue;
+    }
+    return k == Symbol::Kind::Int ? decoder_->decodeInt() : k == Symbol::Kind::Long ? decoder_->decodeLong() : decoder_->decodeFloat();
 }
 
 template<typename P>
 double ResolvingDecoderImpl<P>::decodeDouble() {
     Symbol::Kind k = parser_.advance(Symbol::Kind::Double);
-    return k == Symbol::Kind::Int ? base_->decodeInt() : k == Symbol::Kind::Long ? base_->decodeLong() : k == Symbol::Kind::Float ? base_->decodeFloat() : base_->decodeDouble();
+    if (k == Symbol::Kind::DefaultValue) {
+        return parser_.defaultValue().doubleValue;
+    }
+    return k == Symbol::Kind::Int ? decoder_->decodeInt() : k == Symbol::Kind::Long ? decoder_->decodeLong() : k == Symbol::Kind::Float ? decoder_->decodeFloat() : decoder_->decodeDouble();
 }
 
 template<typename P>
 void ResolvingDecoderImpl<P>::decodeString(string &value) {
-    parser_.advance(Symbol::Kind::String);
-    base_->decodeString(value);
+    if (parser_.advance(Symbol::Kind::String) == Symbol::Kind::DefaultValue) {
+        value = parser_.defaultValue().stringValue;
+        return;
+    }
+    decoder_->decodeString(value);
 }
 
 template<typename P>
 void ResolvingDecoderImpl<P>::skipString() {
-    parser_.advance(Symbol::Kind::String);
-    base_->skipString();
+    if (parser_.advance(Symbol::Kind::String) != Symbol::Kind::DefaultValue) {
+        decoder_->skipString();
+    }
 }
 
 template<typename P>
 void ResolvingDecoderImpl<P>::decodeBytes(vector<uint8_t> &value) {
-    parser_.advance(Symbol::Kind::Bytes);
-    base_->decodeBytes(value);
+    if (parser_.advance(Symbol::Kind::Bytes) == Symbol::Kind::DefaultValue) {
+        value = parser_.defaultValue().bytesValue;
+        return;
+    }
+    decoder_->decodeBytes(value);
 }
 
 template<typename P>
 void ResolvingDecoderImpl<P>::skipBytes() {
-    parser_.advance(Symbol::Kind::Bytes);
-    base_->skipBytes();
+    if (parser_.advance(Symbol::Kind::Bytes) != Symbol::Kind::DefaultValue) {
+        decoder_->skipBytes();
+    }
 }
 
 template<typename P>
 void ResolvingDecoderImpl<P>::decodeFixed(size_t n, vector<uint8_t> &value) {
     parser_.advance(Symbol::Kind::Fixed);
     parser_.assertSize(n);
-    return base_->decodeFixed(n, value);
+    return decoder_->decodeFixed(n, value);
 }
 
 template<typename P>
 void ResolvingDecoderImpl<P>::skipFixed(size_t n) {
     parser_.advance(Symbol::Kind::Fixed);
     parser_.assertSize(n);
-    base_->skipFixed(n);
+    decoder_->skipFixed(n);
 }
 
 template<typename P>
 size_t ResolvingDecoderImpl<P>::decodeEnum() {
     parser_.advance(Symbol::Kind::Enum);
-    size_t n = base_->decodeEnum();
+    size_t n = decoder_->decodeEnum();
     return parser_.enumAdjust(n);
 }
 
 template<typename P>
 size_t ResolvingDecoderImpl<P>::arrayStart() {
     parser_.advance(Symbol::Kind::ArrayStart);
-    size_t result = base_->arrayStart();
+    size_t result = decoder_->arrayStart();
     parser_.pushRepeatCount(result);
     if (result == 0) {
         parser_.popRepeater();
@@ -599,7 +841,7 @@ size_t ResolvingDecoderImpl<P>::arrayStart() {
 template<typename P>
 size_t ResolvingDecoderImpl<P>::arrayNext() {
     parser_.processImplicitActions();
-    size_t result = base_->arrayNext();
+    size_t result = decoder_->arrayNext();
     parser_.nextRepeatCount(result);
     if (result == 0) {
         parser_.popRepeater();
@@ -611,12 +853,12 @@ size_t ResolvingDecoderImpl<P>::arrayNext() {
 template<typename P>
 size_t ResolvingDecoderImpl<P>::skipArray() {
     parser_.advance(Symbol::Kind::ArrayStart);
-    size_t n = base_->skipArray();
+    size_t n = decoder_->skipArray();
     if (n == 0) {
         parser_.pop();
     } else {
         parser_.pushRepeatCount(n);
-        parser_.skip(*base_);
+        parser_.skip(*decoder_);
     }
     parser_.advance(Symbol::Kind::ArrayEnd);
     return 0;
@@ -625,7 +867,7 @@ size_t ResolvingDecoderImpl<P>::skipArray() {
 template<typename P>
 size_t ResolvingDecoderImpl<P>::mapStart() {
     parser_.advance(Symbol::Kind::MapStart);
-    size_t result = base_->mapStart();
+    size_t result = decoder_->mapStart();
     parser_.pushRepeatCount(result);
     if (result == 0) {
         parser_.popRepeater();
@@ -637,7 +879,7 @@ size_t ResolvingDecoderImpl<P>::mapStart() {
 template<typename P>
 size_t ResolvingDecoderImpl<P>::mapNext() {
     parser_.processImplicitActions();
-    size_t result = base_->mapNext();
+    size_t result = decoder_->mapNext();
     parser_.nextRepeatCount(result);
     if (result == 0) {
         parser_.popRepeater();
@@ -649,12 +891,12 @@ size_t ResolvingDecoderImpl<P>::mapNext() {
 template<typename P>
 size_t ResolvingDecoderImpl<P>::skipMap() {
     parser_.advance(Symbol::Kind::MapStart);
-    size_t n = base_->skipMap();
+    size_t n = decoder_->skipMap();
     if (n == 0) {
         parser_.pop();
     } else {
         parser_.pushRepeatCount(n);
-        parser_.skip(*base_);
+        parser_.skip(*decoder_);
     }
     parser_.advance(Symbol::Kind::MapEnd);
     return 0;
@@ -54,7 +54,10 @@ const char *Symbol::stringValues[] = {
     "EnumAdjust",
     "UnionAdjust",
     "SkipStart",
+    "RecordPlan",
+    "PlanStep",
     "Resolve",
+    "DefaultValue",
     "ImplicitActionLow",
     "RecordStart",
     "RecordEnd",
@@ -42,6 +42,14 @@ typedef std::vector<Symbol> Production;
 typedef std::shared_ptr<Production> ProductionPtr;
 typedef boost::tuple<std::stack<ssize_t>, bool, ProductionPtr, ProductionPtr> RepeaterInfo;
 typedef boost::tuple<ProductionPtr, ProductionPtr> RootInfo;
+struct SkipAction;
+typedef std::vector<SkipAction> SkipPlan;
+typedef std::shared_ptr<SkipPlan> SkipPlanPtr;
+struct PlanAction;
+typedef std::vector<PlanAction> RecordPlan;
+typedef std::shared_ptr<RecordPlan> RecordPlanPtr;
+struct DefaultValue;
+typedef std::shared_ptr<const DefaultValue> DefaultValuePtr;
 
 class Symbol {
 public:
@@ -74,7 +82,10 @@ public:
         EnumAdjust,
         UnionAdjust,
         SkipStart,
+        RecordPlan,   // extra is RecordPlanPtr
+        PlanStep,     // Runs the next action of the innermost record plan
         Resolve,
+        DefaultValue, // extra is DefaultValuePtr
 
         ImplicitActionLow,
         RecordStart,
@@ -292,6 +303,101 @@ public:
     static Symbol skipStart() {
         return Symbol(Kind::SkipStart);
     }
+
+    static Symbol recordPlan(RecordPlanPtr plan) {
+        return Symbol(Kind::RecordPlan, std::move(plan));
+    }
+
+    static Symbol planStep() {
+        return Symbol(Kind::PlanStep);
+    }
+
+    static Symbol defaultValue(DefaultValuePtr value) {
+        return Symbol(Kind::DefaultValue, std::move(value));
+    }
+};
+
+/**
+ * The default value of a reader's field that is of a primitive type. It is
+ * handed to the reader as is, in place of the terminal symbol given by kind.
+ */
+struct DefaultValue {
+    Symbol::Kind kind;
+    bool boolValue = false;
+    int64_t longValue = 0; // int and long
+    float floatValue = 0;
+    double doubleValue = 0;
+    std::string stringValue;
+    std::vector<uint8_t> bytesValue;
+
+    explicit DefaultValue(Symbol::Kind k) : kind(k) {}
+};
+
+/**
+ * One step of a precomputed plan for skipping writer data that the reader
+ * does not want. Values whose shape is known when the grammar is built are
+ * skipped by a direct call to the decoder; anything else (arrays, maps,
+ * unions) falls back to skipping the symbol through the grammar.
+ * For the binary encoding, runs of fixed-width values are merged into a
+ * single Fixed step covering all their bytes.
+ * A skip plan covers a run of writer fields the reader drops and is run as
+ * one step of the record's plan.
+ */
+struct SkipAction {
+    enum class Kind {
+        Null,
+        Bool,
+        Int,
+        Long,
+        Float,
+        Double,
+        String,
+        Bytes,
+        Fixed, // size has the length, in bytes, for raw skips
+        Enum,
+        Symbol // symbol has what is to be skipped
+    };
+
+    Kind kind;
+    size_t size;
+    parsing::Symbol symbol;
+
+    explicit SkipAction(Kind k, size_t n = 0) : kind(k), size(n), symbol(parsing::Symbol::nullSymbol()) {}
+    explicit SkipAction(const parsing::Symbol &s) : kind(Kind::Symbol), size(0), symbol(s) {}
+};
+
+/**
+ * One step of the precomputed resolution plan of a record. A plan has a
+ * step per writer field, in writer order, followed by one per reader field
+ * that takes its default; runs of dropped writer fields share a single Skip
+ * step. Reads, promotions and primitive defaults are served by the parser
+ * straight from the plan. Anything else (enums, fixed, arrays, maps, unions,
+ * nested records and other defaults) is handed to the grammar through
+ * symbol; nested records run plans of their own.
+ */
+struct PlanAction {
+    enum class Kind {
+        Read,    // writer has the value of reader's kind
+        Promote, // writer's kind is promoted to reader's
+        Default, // defaultValue is handed out
+        Skip,    // skipPlan drops writer fields
+        Symbol   // symbol is resolved through the grammar
+    };
+
+    Kind kind;
+    parsing::Symbol::Kind writer = parsing::Symbol::Kind::Null;
+    parsing::Symbol::Kind reader = parsing::Symbol::Kind::Null;
+    DefaultValuePtr defaultValue;
+    SkipPlanPtr skipPlan;
+    parsing::Symbol symbol;
+
+    PlanAction(Kind k, parsing::Symbol::Kind w, parsing::Symbol::Kind r) : kind(k), writer(w), reader(r),
+                                                                           symbol(parsing::Symbol::nullSymbol()) {}
+    explicit PlanAction(DefaultValuePtr v) : kind(Kind::Default), defaultValue(std::move(v)),
+                                             symbol(parsing::Symbol::nullSymbol()) {}
+    explicit PlanAction(SkipPlanPtr p) : kind(Kind::Skip), skipPlan(std::move(p)),
+                                         symbol(parsing::Symbol::nullSymbol()) {}
+    explicit PlanAction(const parsing::Symbol &s) : kind(Kind::Symbol), symbol(s) {}
 };
 
 /**
@@ -354,16 +460,70 @@ void fixup(Symbol &s, const std::map<T, ProductionPtr> &m,
             fixup_internal(s.extrap<std::pair<size_t, ProductionPtr>>()->second,
                            m, seen);
             break;
+        case Symbol::Kind::RecordPlan:
+            for (auto &it : **s.extrap<RecordPlanPtr>()) {
+                if (it.kind == PlanAction::Kind::Symbol) {
+                    fixup(it.symbol, m, seen);
+                } else if (it.kind == PlanAction::Kind::Skip) {
+                    for (auto &it2 : *it.skipPlan) {
+                        if (it2.kind == SkipAction::Kind::Symbol) {
+                            fixup(it2.symbol, m, seen);
+                        }
+                    }
+                }
+            }
+            break;
         default:
             break;
     }
 }
 
+/**
+ * A table driven parser. The grammar's productions are treated as the
+ * instruction stream: the parsing stack holds pointers to the symbols
+ * within the productions rather than copies of them, so that advancing
+ * over a value never copies a Symbol or its payload. The productions are
+ * owned by root_ and outlive the stack.
+ *
+ * The item counts of arrays and maps live within the Repeater symbols
+ * themselves. Since nested repeaters always complete before the enclosing
+ * ones resume, a stack of counts per Repeater symbol is sufficient even
+ * for recursive schemas.
+ *
+ * A record with a RecordPlan is run from the plan: its place on the stack
+ * is taken by a PlanStep and a cursor into the plan. The same holds for
+ * plans: a nested plan always completes before the enclosing one resumes.
+ */
 template<typename Handler>
 class SimpleParser {
+    class ParsingStack {
+        std::vector<Symbol *> stack_;
+
+    public:
+        ParsingStack() {
+            stack_.reserve(64);
+        }
+        Symbol &top() const { return *stack_.back(); }
+        void push(Symbol &s) { stack_.push_back(&s); }
+        void pop() { stack_.pop_back(); }
+        size_t size() const { return stack_.size(); }
+        bool empty() const { return stack_.empty(); }
+        void resize(size_t n) { stack_.resize(n); }
+        Symbol &at(size_t n) const { return *stack_[n]; }
+    };
+
+    struct PlanCursor {
+        PlanAction *next;
+        PlanAction *end;
+    };
+
     Decoder *decoder_;
     Handler &handler_;
-    std::stack<Symbol> parsingStack;
+    Symbol root_;
+    Symbol planStep_;
+    ParsingStack parsingStack;
+    std::vector<PlanCursor> planStack_;
+    const DefaultValue *defaultValue_ = nullptr;
 
     static void throwMismatch(Symbol::Kind actual, Symbol::Kind expected) {
         std::ostringstream oss;
@@ -378,20 +538,83 @@ class SimpleParser {
     }
 
     void append(const ProductionPtr &ss) {
-        for (Production::const_iterator it = ss->begin();
-             it != ss->end(); ++it) {
-            parsingStack.push(*it);
+        for (auto &it : *ss) {
+            parsingStack.push(it);
         }
     }
 
+    void append(const std::weak_ptr<Production> &ss) {
+        append(ProductionPtr(ss));
+    }
+
     size_t popSize() {
         const Symbol &s = parsingStack.top();
         assertMatch(Symbol::Kind::SizeCheck, s.kind());
-        auto result = s.extra<size_t>();
+        size_t result = *s.extrap<size_t>();
         parsingStack.pop();
         return result;
     }
 
+    void skipPlan(SkipPlan &plan, Decoder &d) {
+        for (SkipAction &a : plan) {
+            switch (a.kind) {
+                case SkipAction::Kind::Null:
+                    d.decodeNull();
+                    break;
+                case SkipAction::Kind::Bool:
+                    d.decodeBool();
+                    break;
+                case SkipAction::Kind::Int:
+                    d.decodeInt();
+                    break;
+                case SkipAction::Kind::Long:
+                    d.decodeLong();
+                    break;
+                case SkipAction::Kind::Float:
+                    d.decodeFloat();
+                    break;
+                case SkipAction::Kind::Double:
+                    d.decodeDouble();
+                    break;
+                case SkipAction::Kind::String:
+                    d.skipString();
+                    break;
+                case SkipAction::Kind::Bytes:
+                    d.skipBytes();
+                    break;
+                case SkipAction::Kind::Fixed:
+                    d.skipFixed(a.size);
+                    break;
+                case SkipAction::Kind::Enum:
+                    d.decodeEnum();
+                    break;
+                case SkipAction::Kind::Symbol:
+                    parsingStack.push(a.symbol);
+                    skip(d);
+                    break;
+            }
+        }
+    }
+
+    void startPlan(RecordPlan &plan) {
+        if (!plan.empty()) {
+            planStack_.push_back(PlanCursor{plan.data(), plan.data() + plan.size()});
+            parsingStack.push(planStep_);
+        }
+    }
+
+    // Takes the next action of the innermost plan, and leaves the plan
+    // once its last action is taken.
+    PlanAction &nextAction() {
+        PlanCursor &c = planStack_.back();
+        PlanAction &result = *c.next++;
+        if (c.next == c.end) {
+            planStack_.pop_back();
+            parsingStack.pop();
+        }
+        return result;
+    }
+
     static void assertLessThan(size_t n, size_t s) {
         if (n >= s) {
             std::ostringstream oss;
@@ -416,19 +639,13 @@ public:
                     case Symbol::Kind::Root:
                         append(boost::tuples::get<0>(*s.extrap<RootInfo>()));
                         continue;
-                    case Symbol::Kind::Indirect: {
-                        ProductionPtr pp =
-                            s.extra<ProductionPtr>();
+                    case Symbol::Kind::Indirect:
                         parsingStack.pop();
-                        append(pp);
-                    }
+                        append(*s.extrap<ProductionPtr>());
                         continue;
-                    case Symbol::Kind::Symbolic: {
-                        ProductionPtr pp(
-                            s.extra<std::weak_ptr<Production>>());
+                    case Symbol::Kind::Symbolic:
                         parsingStack.pop();
-                        append(pp);
-                    }
+                        append(*s.extrap<std::weak_ptr<Production>>());
                         continue;
                     case Symbol::Kind::Repeater: {
                         auto *p = s.extrap<RepeaterInfo>();
@@ -455,10 +672,40 @@ public:
                         parsingStack.pop();
                         return result;
                     }
+                    case Symbol::Kind::DefaultValue: {
+                        const DefaultValue *v = s.extrap<DefaultValuePtr>()->get();
+                        assertMatch(v->kind, k);
+                        defaultValue_ = v;
+                        parsingStack.pop();
+                        return Symbol::Kind::DefaultValue;
+                    }
                     case Symbol::Kind::SkipStart:
                         parsingStack.pop();
                         skip(*decoder_);
                         break;
+                    case Symbol::Kind::RecordPlan:
+                        parsingStack.pop();
+                        startPlan(**s.extrap<RecordPlanPtr>());
+                        break;
+                    case Symbol::Kind::PlanStep: {
+                        PlanAction &a = nextAction();
+                        switch (a.kind) {
+                            case PlanAction::Kind::Read:
+                            case PlanAction::Kind::Promote:
+                                assertMatch(k, a.reader);
+                                return a.writer;
+                            case PlanAction::Kind::Default:
+                                assertMatch(a.defaultValue->kind, k);
+                                defaultValue_ = a.defaultValue.get();
+                                return Symbol::Kind::DefaultValue;
+                            case PlanAction::Kind::Skip:
+                                skipPlan(*a.skipPlan, *decoder_);
+                                break;
+                            case PlanAction::Kind::Symbol:
+                                parsingStack.push(a.symbol);
+                                break;
+                        }
+                    } break;
                     default:
                         if (s.isImplicitAction()) {
                             size_t n = handler_.handle(s);
@@ -545,7 +792,7 @@ public:
                 case Symbol::Kind::Fixed: {
                     parsingStack.pop();
                     Symbol &t2 = parsingStack.top();
-                    d.decodeFixed(t2.extra<size_t>());
+                    d.decodeFixed(*t2.extrap<size_t>());
                 } break;
                 case Symbol::Kind::Enum:
                     parsingStack.pop();
@@ -578,19 +825,13 @@ public:
                     }
                     break;
                 }
-                case Symbol::Kind::Indirect: {
-                    ProductionPtr pp =
-                        t.extra<ProductionPtr>();
+                case Symbol::Kind::Indirect:
                     parsingStack.pop();
-                    append(pp);
-                }
+                    append(*t.extrap<ProductionPtr>());
                     continue;
-                case Symbol::Kind::Symbolic: {
-                    ProductionPtr pp(
-                        t.extra<std::weak_ptr<Production>>());
+                case Symbol::Kind::Symbolic:
                     parsingStack.pop();
-                    append(pp);
-                }
+                    append(*t.extrap<std::weak_ptr<Production>>());
                     continue;
                 default: {
                     std::ostringstream oss;
@@ -636,18 +877,16 @@ public:
     size_t unionAdjust() {
         const Symbol &s = parsingStack.top();
         assertMatch(Symbol::Kind::UnionAdjust, s.kind());
-        std::pair<size_t, ProductionPtr> p =
-            s.extra<std::pair<size_t, ProductionPtr>>();
+        const auto *p = s.extrap<std::pair<size_t, ProductionPtr>>();
         parsingStack.pop();
-        append(p.second);
-        return p.first;
+        append(p->second);
+        return p->first;
     }
 
     std::string nameForIndex(size_t e) {
         const Symbol &s = parsingStack.top();
         assertMatch(Symbol::Kind::NameList, s.kind());
-        const std::vector<std::string> names =
-            s.extra<std::vector<std::string>>();
+        const auto &names = *s.extrap<std::vector<std::string>>();
         if (e >= names.size()) {
             throw Exception("Not that many names");
         }
@@ -659,8 +898,7 @@ public:
     size_t indexForName(const std::string &name) {
         const Symbol &s = parsingStack.top();
         assertMatch(Symbol::Kind::NameList, s.kind());
-        const std::vector<std::string> names =
-            s.extra<std::vector<std::string>>();
+        const auto &names = *s.extrap<std::vector<std::string>>();
         auto it = std::find(names.begin(), names.end(), name);
         if (it == names.end()) {
             throw Exception("No such enum symbol");
@@ -710,8 +948,7 @@ public:
     void selectBranch(size_t n) {
         const Symbol &s = parsingStack.top();
         assertMatch(Symbol::Kind::Alternative, s.kind());
-        std::vector<ProductionPtr> v =
-            s.extra<std::vector<ProductionPtr>>();
+        const auto &v = *s.extrap<std::vector<ProductionPtr>>();
         if (n >= v.size()) {
             throw Exception("Not that many branches");
         }
@@ -729,6 +966,14 @@ public:
         return parsingStack.top().kind();
     }
 
+    /**
+     * Returns the default value reached by the last advance() that
+     * returned Symbol::Kind::DefaultValue.
+     */
+    const DefaultValue &defaultValue() const {
+        return *defaultValue_;
+    }
+
     void pop() {
         parsingStack.pop();
     }
@@ -742,20 +987,44 @@ public:
             } else if (s.kind() == Symbol::Kind::SkipStart) {
                 parsingStack.pop();
                 skip(*decoder_);
+            } else if (s.kind() == Symbol::Kind::RecordPlan) {
+                parsingStack.pop();
+                startPlan(**s.extrap<RecordPlanPtr>());
+            } else if (s.kind() == Symbol::Kind::PlanStep
+                       && planStack_.back().next->kind == PlanAction::Kind::Skip) {
+                skipPlan(*nextAction().skipPlan, *decoder_);
             } else {
                 break;
             }
         }
     }
 
-    SimpleParser(const Symbol &s, Decoder *d, Handler &h) : decoder_(d), handler_(h) {
-        parsingStack.push(s);
+    SimpleParser(const Symbol &s, Decoder *d, Handler &h) : decoder_(d), handler_(h), root_(s),
+                                                            planStep_(Symbol::planStep()) {
+        parsingStack.push(root_);
     }
 
+    SimpleParser(const SimpleParser &) = delete;
+    SimpleParser &operator=(const SimpleParser &) = delete;
+
+    /**
+     * Abandons the current parse, if any, and prepares to parse a new
+     * top-level value. Since item counts are kept in the grammar, the
+     * repeaters that are still pending are cleared here.
+     */
     void reset() {
-        while (parsingStack.size() > 1) {
-            parsingStack.pop();
+        for (size_t i = 1; i < parsingStack.size(); ++i) {
+            Symbol &s = parsingStack.at(i);
+            if (s.kind() == Symbol::Kind::Repeater) {
+                std::stack<ssize_t> &ns =
+                    boost::tuples::get<0>(*s.extrap<RepeaterInfo>());
+                while (!ns.empty()) {
+                    ns.pop();
+                }
+            }
         }
+        parsingStack.resize(1);
+        planStack_.clear();
     }
 };
 
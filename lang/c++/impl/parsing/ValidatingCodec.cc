@@ -378,6 +378,7 @@ class ValidatingEncoder : public Encoder {
     void encodeFloat(float f) final;
     void encodeDouble(double d) final;
     void encodeString(const std::string &s) final;
+    void encodeString(const char *s, size_t len) final;
     void encodeBytes(const uint8_t *bytes, size_t len) final;
     void encodeFixed(const uint8_t *bytes, size_t len) final;
     void encodeEnum(size_t e) final;
@@ -446,6 +447,12 @@ void ValidatingEncoder<P>::encodeString(const std::string &s) {
     base_->encodeString(s);
 }
 
+template<typename P>
+void ValidatingEncoder<P>::encodeString(const char *s, size_t len) {
+    parser_.advance(Symbol::Kind::String);
+    base_->encodeString(s, len);
+}
+
 template<typename P>
 void ValidatingEncoder<P>::encodeBytes(const uint8_t *bytes, size_t len) {
     parser_.advance(Symbol::Kind::Bytes);
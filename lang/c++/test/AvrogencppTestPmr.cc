@@ -0,0 +1,158 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bigrecord_pmr.hh"
+
+#include <boost/test/included/unit_test_framework.hpp>
+
+using std::string;
+using std::unique_ptr;
+
+using avro::binaryDecoder;
+using avro::binaryEncoder;
+using avro::DecoderPtr;
+using avro::EncoderPtr;
+using avro::InputStream;
+using avro::memoryInputStream;
+using avro::memoryOutputStream;
+using avro::OutputStream;
+
+/// A memory resource that counts the allocations made through it.
+class CountingResource : public std::pmr::memory_resource {
+    std::pmr::memory_resource *upstream_;
+
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        ++count;
+        return upstream_->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        upstream_->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    size_t count;
+
+    explicit CountingResource(std::pmr::memory_resource *upstream) : upstream_(upstream), count(0) {}
+};
+
+void setRecord(testgen_pmr::RootRecord &r) {
+    const string longString(100, 's');
+    r.mylong = 212;
+    r.nestedrecord.inval1 = 3.14;
+    r.nestedrecord.inval2 = longString.c_str();
+    r.nestedrecord.inval3 = 100;
+    r.mymap["one"] = 100;
+    r.mymap["two"] = 200;
+    r.mymap["a key too long to be held inline"] = 300;
+    r.recordmap["nested"].inval2 = longString.c_str();
+    r.myarray.assign(50, 3.4);
+    r.myenum = testgen_pmr::ExampleEnum::two;
+    r.myunion.set_null();
+    r.anotherunion.set_null();
+    r.mybool = true;
+    r.anothernested.inval2 = longString.c_str();
+    r.anotherint = 4534;
+    r.bytes.assign(40, 7);
+}
+
+void testPmrDecode() {
+    testgen_pmr::RootRecord t1;
+    setRecord(t1);
+    unique_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    avro::encode(*e, t1);
+    e->flush();
+
+    CountingResource defaults(std::pmr::new_delete_resource());
+    CountingResource arena(std::pmr::new_delete_resource());
+    std::pmr::memory_resource *old = std::pmr::set_default_resource(&defaults);
+    {
+        std::pmr::monotonic_buffer_resource batch(&arena);
+        std::pmr::vector<testgen_pmr::RootRecord> records(&batch);
+        records.resize(3);
+        DecoderPtr d = binaryDecoder();
+        for (auto &r : records) {
+            unique_ptr<InputStream> is = memoryInputStream(*os);
+            d->init(*is);
+            avro::decode(*d, r);
+        }
+        for (const auto &r : records) {
+            BOOST_CHECK_EQUAL(r.mylong, t1.mylong);
+            BOOST_CHECK(r.nestedrecord.inval2 == t1.nestedrecord.inval2);
+            BOOST_CHECK(r.mymap == t1.mymap);
+            BOOST_CHECK(r.recordmap.at("nested").inval2 == t1.recordmap.at("nested").inval2);
+            BOOST_CHECK(r.myarray == t1.myarray);
+            BOOST_CHECK(r.myunion.is_null());
+            BOOST_CHECK(r.anothernested.inval2 == t1.anothernested.inval2);
+            BOOST_CHECK(r.bytes == t1.bytes);
+            BOOST_CHECK(r.nestedrecord.inval2.get_allocator().resource() == &batch);
+            BOOST_CHECK(r.recordmap.at("nested").inval2.get_allocator().resource() == &batch);
+        }
+
+        // The copy of a record into the batch allocates there too.
+        records.push_back(t1);
+        BOOST_CHECK(records.back().mymap.get_allocator().resource() == &batch);
+        BOOST_CHECK(records.back().mymap == t1.mymap);
+    }
+    std::pmr::set_default_resource(old);
+
+    BOOST_CHECK(arena.count > 0);
+    BOOST_CHECK_EQUAL(defaults.count, 0);
+}
+
+void testPmrTemporaryDefault() {
+    testgen_pmr::RootRecord t1;
+    setRecord(t1);
+    unique_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    avro::encode(*e, t1);
+    e->flush();
+
+    // Each batch makes its arena the default resource while decoding and
+    // destroys it afterwards. Nothing decoded may outlive its batch.
+    DecoderPtr d = binaryDecoder();
+    for (int i = 0; i < 3; ++i) {
+        CountingResource arena(std::pmr::new_delete_resource());
+        std::pmr::memory_resource *old = std::pmr::set_default_resource(&arena);
+        {
+            std::pmr::monotonic_buffer_resource batch(&arena);
+            testgen_pmr::RootRecord r(&batch);
+            unique_ptr<InputStream> is = memoryInputStream(*os);
+            d->init(*is);
+            avro::decode(*d, r);
+            BOOST_CHECK(r.mymap == t1.mymap);
+            BOOST_CHECK(r.mymap.begin()->first.get_allocator().resource() == &batch);
+        }
+        std::pmr::set_default_resource(old);
+        BOOST_CHECK(arena.count > 0);
+    }
+}
+
+boost::unit_test::test_suite *
+init_unit_test_suite(int /* argc */, char * /*argv*/[]) {
+    auto *ts = BOOST_TEST_SUITE("Code generator tests for std::pmr");
+    ts->add(BOOST_TEST_CASE(testPmrDecode));
+    ts->add(BOOST_TEST_CASE(testPmrTemporaryDefault));
+    return ts;
+}
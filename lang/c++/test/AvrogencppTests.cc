@@ -18,12 +18,24 @@
 
 #include "Compiler.hh"
 #include "bigrecord.hh"
+#include "bigrecord_flat.hh"
 #include "bigrecord_r.hh"
+#include "bigrecord_r_from_bigrecord.hh"
+#include "bigrecord_tagged.hh"
+#include "bigrecord_unordered.hh"
+#include "bigrecord_views.hh"
+// Unions within recursive types keep holding their values in an any.
+#include "recursive_tagged.hh"
+#include "recursive_views.hh"
+#include "sortorder_compare.hh"
 #include "tweet.hh"
 #include "union_array_union.hh"
 #include "union_map_union.hh"
 
 #include <boost/test/included/unit_test_framework.hpp>
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
 
 #ifdef min
 #undef min
@@ -120,7 +132,8 @@ void checkRecord(const T1 &r1, const T2 &r2) {
     BOOST_CHECK_EQUAL(static_cast<unsigned int>(r1.myenum), static_cast<unsigned int>(r2.myenum));
 }
 
-void checkDefaultValues(const testgen_r::RootRecord &r) {
+template<typename T>
+void checkDefaultValues(const T &r) {
     BOOST_CHECK_EQUAL(r.withDefaultValue.s1, "\"sval\\u8352\"");
     BOOST_CHECK_EQUAL(r.withDefaultValue.i1, 99);
     BOOST_CHECK_CLOSE(r.withDefaultValue.d1, 5.67, 1e-10);
@@ -129,6 +142,13 @@ void checkDefaultValues(const testgen_r::RootRecord &r) {
     BOOST_CHECK_EQUAL(r.myfixedwithDefaultValue.get_val()[0], 0x01);
     BOOST_CHECK_EQUAL(r.byteswithDefaultValue.get_bytes()[0], 0xff);
     BOOST_CHECK_EQUAL(r.byteswithDefaultValue.get_bytes()[1], 0xaa);
+    BOOST_CHECK_EQUAL(r.stringwithDefaultValue, "\"?\?=\" \xc3\xa9");
+    BOOST_REQUIRE_EQUAL(r.plainbyteswithDefaultValue.size(), 2);
+    BOOST_CHECK_EQUAL(r.plainbyteswithDefaultValue[0], 0x00);
+    BOOST_CHECK_EQUAL(r.plainbyteswithDefaultValue[1], 0xff);
+    BOOST_REQUIRE_EQUAL(r.mapwithDefaultValue.size(), 2);
+    BOOST_CHECK_EQUAL(r.mapwithDefaultValue.at("a"), 1);
+    BOOST_CHECK_EQUAL(r.mapwithDefaultValue.at("b"), 2);
 }
 
 void testEncoding() {
@@ -205,6 +225,40 @@ void testResolution() {
     BOOST_CHECK_EQUAL(oss_r.str(), oss_rs.str());
 }
 
+static_assert(testgen::RootRecord::avroFingerprint() != 0,
+              "the fingerprint is known at compile time");
+
+void testEmbeddedSchema() {
+    ValidSchema s_w;
+    ifstream ifs_w("jsonschemas/bigrecord");
+    compileJsonSchema(ifs_w, s_w);
+    BOOST_CHECK_EQUAL(testgen::RootRecord::avroFingerprint(), s_w.fingerprint());
+    BOOST_CHECK_EQUAL(testgen::RootRecord::avroCanonicalJson(), s_w.toCanonicalJson());
+    BOOST_CHECK_EQUAL(testgen::RootRecord::avroSchemaJson(), s_w.toJson(false));
+
+    const ValidSchema &s = testgen::RootRecord::avroSchema();
+    BOOST_CHECK_EQUAL(&s, &testgen::RootRecord::avroSchema());
+    BOOST_CHECK_EQUAL(s.fingerprint(), testgen::RootRecord::avroFingerprint());
+    BOOST_CHECK(testgen_r::RootRecord::avroFingerprint() != testgen::RootRecord::avroFingerprint());
+
+    unique_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = validatingEncoder(s, binaryEncoder());
+    e->init(*os);
+    testgen::RootRecord t1;
+    setRecord(t1);
+    avro::encode(*e, t1);
+    e->flush();
+
+    // The embedded reader's schema keeps its default values.
+    DecoderPtr rd = resolvingDecoder(s, testgen_r::RootRecord::avroSchema(), binaryDecoder());
+    unique_ptr<InputStream> is = memoryInputStream(*os);
+    rd->init(*is);
+    testgen_r::RootRecord t2;
+    avro::decode(*rd, t2);
+    checkRecord(t2, t1);
+    checkDefaultValues(t2);
+}
+
 void testNamespace() {
     ValidSchema s;
     ifstream ifs("jsonschemas/tweet");
@@ -219,6 +273,66 @@ void testNamespace() {
     twPoint.set_AvroPoint(point);
 }
 
+// Tagged unions move without throwing when their branch types do.
+static_assert(std::is_nothrow_move_constructible<testgen_t::_bigrecord_Union__1__>::value,
+              "a union of bytes moves without throwing");
+static_assert(std::is_nothrow_move_assignable<testgen_t::_bigrecord_Union__1__>::value,
+              "a union of bytes moves without throwing");
+
+void testTaggedUnions() {
+    ValidSchema s;
+    ifstream ifs("jsonschemas/bigrecord");
+    compileJsonSchema(ifs, s);
+    unique_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = validatingEncoder(s, binaryEncoder());
+    e->init(*os);
+    testgen::RootRecord t1;
+    setRecord(t1);
+    avro::encode(*e, t1);
+    e->flush();
+
+    // Decode the record into tagged unions, twice into the same object,
+    // encode it again and read the result back.
+    DecoderPtr d = validatingDecoder(s, binaryDecoder());
+    testgen_t::RootRecord t2;
+    t2.myunion.set_float(1.5f);
+    for (int i = 0; i < 2; ++i) {
+        unique_ptr<InputStream> is = memoryInputStream(*os);
+        d->init(*is);
+        avro::decode(*d, t2);
+        checkRecord(t2, t1);
+    }
+
+    unique_ptr<OutputStream> os2 = memoryOutputStream();
+    e->init(*os2);
+    avro::encode(*e, t2);
+    e->flush();
+    unique_ptr<InputStream> is2 = memoryInputStream(*os2);
+    d->init(*is2);
+    testgen::RootRecord t3;
+    avro::decode(*d, t3);
+    checkRecord(t3, t1);
+
+    typedef testgen_t::_bigrecord_Union__0__ MyUnion;
+    MyUnion u;
+    BOOST_CHECK(u.is_null());
+    BOOST_CHECK_THROW(u.get_float(), avro::Exception);
+    std::map<string, int32_t> &m = u.emplace_map();
+    m["a"] = 1;
+    BOOST_CHECK_EQUAL(u.idx(), 1);
+    MyUnion copy = u;
+    BOOST_CHECK(copy.get_map() == m);
+    MyUnion moved = std::move(copy);
+    BOOST_CHECK_EQUAL(moved.get_map().size(), 1);
+    moved.set_float(2.5f);
+    BOOST_CHECK_EQUAL(moved.get_float(), 2.5f);
+    moved = u;
+    BOOST_CHECK(moved.get_map() == m);
+    u.set_null();
+    moved = std::move(u);
+    BOOST_CHECK(moved.is_null());
+}
+
 void setRecord(uau::r1 &r) {
 }
 
@@ -244,6 +358,340 @@ struct schemaFilename<umu::r1> {
 };
 const char schemaFilename<umu::r1>::value[] = "jsonschemas/union_map_union";
 
+void testEncodedSize() {
+    testgen::RootRecord t1;
+    setRecord(t1);
+    unique_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    avro::encode(*e, t1);
+    e->flush();
+    BOOST_CHECK_EQUAL(avro::encodedSize(t1), os->byteCount());
+
+    DecoderPtr d = binaryDecoder();
+    unique_ptr<InputStream> is = memoryInputStream(*os);
+    d->init(*is);
+    testgen_t::RootRecord t2;
+    avro::decode(*d, t2);
+    BOOST_CHECK_EQUAL(avro::encodedSize(t2), os->byteCount());
+
+    t1.myunion.set_null();
+    t1.anotherunion.set_null();
+    t1.myenum = testgen::ExampleEnum::three;
+    unique_ptr<OutputStream> os2 = memoryOutputStream();
+    e->init(*os2);
+    avro::encode(*e, t1);
+    e->flush();
+    BOOST_CHECK_EQUAL(avro::encodedSize(t1), os2->byteCount());
+}
+
+void testViews() {
+    testgen::RootRecord t1;
+    setRecord(t1);
+    t1.nestedrecord.inval2 = "nested";
+    unique_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    avro::encode(*e, t1);
+    e->flush();
+    std::shared_ptr<std::vector<uint8_t>> data = snapshot(*os);
+
+    // Fields are read out of order, so that the offsets of the ones in
+    // between are found on the way.
+    testgen_v::RootRecord_View v(data->data(), data->size());
+    BOOST_CHECK_EQUAL(v.anotherint(), t1.anotherint);
+    BOOST_CHECK_EQUAL(v.mylong(), t1.mylong);
+    BOOST_CHECK_EQUAL(v.nestedrecord().inval2(), "nested");
+    BOOST_CHECK_EQUAL(v.anothernested().inval3(), t1.anothernested.inval3);
+    BOOST_CHECK(v.mymap() == t1.mymap);
+    BOOST_CHECK(v.myarray() == t1.myarray);
+    BOOST_CHECK_EQUAL(static_cast<unsigned>(v.myenum()), static_cast<unsigned>(t1.myenum));
+    BOOST_CHECK(v.myunion().get_map() == t1.myunion.get_map());
+    BOOST_CHECK(v.anotherunion().get_bytes() == t1.anotherunion.get_bytes());
+    BOOST_CHECK_EQUAL(v.mybool(), t1.mybool);
+    BOOST_CHECK_EQUAL(v.myfixed().size(), t1.myfixed.size());
+    BOOST_CHECK(std::equal(t1.myfixed.begin(), t1.myfixed.end(),
+                           reinterpret_cast<const uint8_t *>(v.myfixed().data())));
+    BOOST_CHECK_EQUAL(v.bytes().size(), t1.bytes.size());
+    BOOST_CHECK_EQUAL(v.encodedSize(), data->size());
+
+    // A copy keeps the offsets found so far, and one view may be read
+    // from several threads at once.
+    testgen_v::RootRecord_View fresh(data->data(), data->size());
+    BOOST_CHECK_EQUAL(fresh.mylong(), t1.mylong);
+    const testgen_v::RootRecord_View copy = fresh;
+    bool sizes[2] = {false, false};
+    std::thread r0([&] { sizes[0] = copy.encodedSize() == data->size(); });
+    std::thread r1([&] { sizes[1] = copy.mybool() == t1.mybool && copy.encodedSize() == data->size(); });
+    r0.join();
+    r1.join();
+    BOOST_CHECK(sizes[0] && sizes[1]);
+
+    // An enum index past the last symbol is rejected, as codec_traits does.
+    testgen::RootRecord t2 = t1;
+    t2.myenum = t1.myenum == testgen::ExampleEnum::one ? testgen::ExampleEnum::two
+                                                       : testgen::ExampleEnum::one;
+    unique_ptr<OutputStream> os2 = memoryOutputStream();
+    e->init(*os2);
+    avro::encode(*e, t2);
+    e->flush();
+    std::shared_ptr<std::vector<uint8_t>> bad = snapshot(*os2);
+    BOOST_REQUIRE_EQUAL(bad->size(), data->size());
+    size_t at = std::mismatch(data->begin(), data->end(), bad->begin()).first - data->begin();
+    (*bad)[at] = 0x7e;
+    BOOST_CHECK_THROW(testgen_v::RootRecord_View(bad->data(), bad->size()).myenum(),
+                      avro::Exception);
+
+    testgen_v::RootRecord_View truncated(data->data(), data->size() - 1);
+    BOOST_CHECK_EQUAL(truncated.mylong(), t1.mylong);
+    BOOST_CHECK_THROW(truncated.encodedSize(), avro::Exception);
+
+    // A list of 1 and 2: the skip of a recursive field goes through views.
+    const uint8_t list[] = {0x02, 0x00, 0x04, 0x02};
+    rec_v::LongList_View lv(list, sizeof(list));
+    BOOST_CHECK_EQUAL(lv.value(), 1);
+    BOOST_CHECK_EQUAL(lv.encodedSize(), sizeof(list));
+    BOOST_CHECK_THROW(rec_v::LongList_View(list, sizeof(list) - 1).encodedSize(),
+                      avro::Exception);
+}
+
+void testResolvedDecoder() {
+    ValidSchema s_w;
+    ifstream ifs_w("jsonschemas/bigrecord");
+    compileJsonSchema(ifs_w, s_w);
+    unique_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    testgen::RootRecord t1;
+    setRecord(t1);
+    avro::encode(*e, t1);
+    avro::encode(*e, t1);
+    e->flush();
+
+    DecoderPtr d = binaryDecoder();
+    unique_ptr<InputStream> is = memoryInputStream(*os);
+    d->init(*is);
+    testgen_rr::RootRecord t2;
+    BOOST_CHECK(!testgen_rr::decodeFrom(s_w.fingerprint() + 1, *d, t2));
+    BOOST_REQUIRE(testgen_rr::decodeFrom(s_w.fingerprint(), *d, t2));
+    checkRecord(t2, t1);
+    checkDefaultValues(t2);
+
+    // Decoding again into the same object must not accumulate elements,
+    // must restore the defaults and must reuse the map entries still there.
+    t2.stringwithDefaultValue = "changed";
+    t2.plainbyteswithDefaultValue.clear();
+    t2.mapwithDefaultValue["c"] = 3;
+    t2.mymap["stale"] = 1;
+    const string *inval2 = &t2.recordmap.begin()->second.inval2;
+    BOOST_REQUIRE(testgen_rr::decodeFrom(s_w.fingerprint(), *d, t2));
+    checkRecord(t2, t1);
+    checkDefaultValues(t2);
+    BOOST_CHECK_EQUAL(t2.myarraywithDefaultValue.size(), 2);
+    BOOST_CHECK(t2.mymap.find("stale") == t2.mymap.end());
+    BOOST_CHECK(&t2.recordmap.begin()->second.inval2 == inval2);
+}
+
+template<typename T>
+struct has_compare {
+    template<typename U>
+    static std::true_type test(decltype(compare(std::declval<const U &>(), std::declval<const U &>())) *);
+
+    template<typename U>
+    static std::false_type test(...);
+
+    static const bool value = decltype(test<T>(nullptr))::value;
+};
+
+static so::Key makeKey(int64_t id, const string &name) {
+    so::Key k;
+    k.id = id;
+    k.name = name;
+    k.kind = so::Kind::small;
+    k.digest = {{1, 2, 3, 4}};
+    so::Part p;
+    p.label = "a";
+    p.size = 1;
+    k.parts.push_back(p);
+    k.extra.set_string("x");
+    k.score = 1.0;
+    return k;
+}
+
+void testCompare() {
+    so::Key k1 = makeKey(1, "a");
+    so::Key k2 = makeKey(1, "a");
+    // Fields with "order": "ignore" take no part.
+    k2.attributes["k"] = "v";
+    k2.score = 2.0;
+    BOOST_CHECK(k1 == k2);
+    BOOST_CHECK_EQUAL(compare(k1, k2), 0);
+    BOOST_CHECK_EQUAL(std::hash<so::Key>()(k1), std::hash<so::Key>()(k2));
+
+    // "id" is descending.
+    k2.id = 2;
+    BOOST_CHECK(k1 != k2);
+    BOOST_CHECK_GT(compare(k1, k2), 0);
+    BOOST_CHECK_LT(compare(k2, k1), 0);
+
+    // Strings sort by code point, bytes as unsigned.
+    k2 = makeKey(1, "z");
+    BOOST_CHECK_LT(compare(k1, k2), 0);
+    k1.name = "\xc3\xa9";
+    BOOST_CHECK_GT(compare(k1, k2), 0);
+
+    k1 = makeKey(1, "a");
+    k2 = makeKey(1, "a");
+    k2.kind = so::Kind::large;
+    BOOST_CHECK_LT(compare(k1, k2), 0);
+    k2 = makeKey(1, "a");
+    k2.digest[0] = 0xff;
+    BOOST_CHECK_LT(compare(k1, k2), 0);
+
+    // A shorter array sorts before one it is a prefix of.
+    k2 = makeKey(1, "a");
+    k2.parts.push_back(k2.parts[0]);
+    BOOST_CHECK_LT(compare(k1, k2), 0);
+    k2.parts.pop_back();
+    k2.parts[0].size = 0;
+    BOOST_CHECK_GT(compare(k1, k2), 0);
+
+    // Unions sort by branch, then by value.
+    k2 = makeKey(1, "a");
+    k2.extra.set_null();
+    BOOST_CHECK_GT(compare(k1, k2), 0);
+    k2.extra.set_Part(k1.parts[0]);
+    BOOST_CHECK_LT(compare(k1, k2), 0);
+    k1.extra.set_Part(k1.parts[0]);
+    BOOST_CHECK(k1 == k2);
+    BOOST_CHECK_EQUAL(std::hash<so::Key>()(k1), std::hash<so::Key>()(k2));
+
+    std::unordered_set<so::Key> keys;
+    keys.insert(makeKey(1, "a"));
+    keys.insert(makeKey(1, "a"));
+    keys.insert(makeKey(2, "a"));
+    BOOST_CHECK_EQUAL(keys.size(), 2);
+
+    std::vector<so::Key> sorted;
+    sorted.push_back(makeKey(1, "b"));
+    sorted.push_back(makeKey(2, "b"));
+    sorted.push_back(makeKey(1, "a"));
+    std::sort(sorted.begin(), sorted.end(),
+              [](const so::Key &a, const so::Key &b) { return compare(a, b) < 0; });
+    BOOST_CHECK_EQUAL(sorted[0].id, 2);
+    BOOST_CHECK_EQUAL(sorted[1].name, "a");
+    BOOST_CHECK_EQUAL(sorted[2].name, "b");
+
+    BOOST_CHECK_THROW(avro::compare(k1.attributes, k2.attributes), avro::Exception);
+
+    // A record with a map that is not ignored has equality and hashing,
+    // but no compare().
+    so::Labels l1;
+    so::Labels l2;
+    l2.counts["a"] = 1;
+    BOOST_CHECK(l1 != l2);
+    l1.counts["a"] = 1;
+    BOOST_CHECK(l1 == l2);
+    BOOST_CHECK_EQUAL(std::hash<so::Labels>()(l1), std::hash<so::Labels>()(l2));
+    BOOST_CHECK(has_compare<so::Key>::value);
+    BOOST_CHECK(!has_compare<so::Labels>::value);
+}
+
+void testArrayOrder() {
+    // Every container that holds arrays sorts and hashes them alike, also
+    // when they are nested in one another.
+    typedef boost::container::small_vector<int32_t, 2> Small;
+    typedef boost::container::static_vector<Small, 4> Static;
+    vector<vector<int32_t>> v1 = {{1, 2, 3}, {4}};
+    vector<vector<int32_t>> v2 = {{1, 2, 3}, {4, 0}};
+    vector<Small> s1 = {{1, 2, 3}, {4}};
+    vector<Small> s2 = {{1, 2, 3}, {4, 0}};
+    Static t1 = {{1, 2, 3}, {4}};
+    Static t2 = {{1, 2, 3}, {4, 0}};
+    BOOST_CHECK_EQUAL(avro::compare(v1, v2), -1);
+    BOOST_CHECK_EQUAL(avro::compare(s1, s2), -1);
+    BOOST_CHECK_EQUAL(avro::compare(t1, t2), -1);
+    BOOST_CHECK_EQUAL(avro::compare(t2, t1), 1);
+    BOOST_CHECK_EQUAL(avro::compare(s1, s1), 0);
+    BOOST_CHECK_EQUAL(avro::hashValue(v1), avro::hashValue(s1));
+    BOOST_CHECK_EQUAL(avro::hashValue(v2), avro::hashValue(t2));
+}
+
+void testContainers() {
+    unique_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    testgen::RootRecord t1;
+    setRecord(t1);
+    t1.recordmap["nested"] = t1.nestedrecord;
+    avro::encode(*e, t1);
+    e->flush();
+
+    DecoderPtr d = binaryDecoder();
+    unique_ptr<InputStream> is = memoryInputStream(*os);
+    d->init(*is);
+    testgen_u::RootRecord t2;
+    avro::decode(*d, t2);
+    BOOST_CHECK_EQUAL(t2.mymap.size(), 2);
+    BOOST_CHECK_EQUAL(t2.mymap.at("one"), 100);
+    BOOST_CHECK_EQUAL(t2.mymap.at("two"), 200);
+    BOOST_CHECK_EQUAL(t2.recordmap.at("nested").inval2, "hello world");
+    // The array outgrows the inline capacity of 2.
+    BOOST_CHECK(std::equal(t2.myarray.begin(), t2.myarray.end(), t1.myarray.begin()));
+    BOOST_CHECK_EQUAL(t2.myarray.size(), 3);
+    BOOST_CHECK_EQUAL(t2.myunion.get_map().at("two"), 2);
+    BOOST_CHECK_EQUAL(avro::encodedSize(t2), os->byteCount());
+
+    unique_ptr<InputStream> is3 = memoryInputStream(*os);
+    d->init(*is3);
+    testgen_f::RootRecord t3;
+    avro::decode(*d, t3);
+    BOOST_REQUIRE_EQUAL(t3.mymap.size(), 2);
+    BOOST_CHECK_EQUAL(t3.mymap[0].first, "one");
+    BOOST_CHECK_EQUAL(t3.mymap[0].second, 100);
+    BOOST_CHECK_EQUAL(t3.mymap[1].first, "two");
+    BOOST_CHECK_EQUAL(t3.mymap[1].second, 200);
+    BOOST_CHECK(std::equal(t3.myarray.begin(), t3.myarray.end(), t1.myarray.begin()));
+
+    // Flat maps keep the order of the encoding, so encode the same bytes.
+    unique_ptr<OutputStream> os2 = memoryOutputStream();
+    e->init(*os2);
+    avro::encode(*e, t3);
+    e->flush();
+    BOOST_CHECK_EQUAL(avro::encodedSize(t3), os->byteCount());
+    unique_ptr<InputStream> is1 = memoryInputStream(*os);
+    unique_ptr<InputStream> is2 = memoryInputStream(*os2);
+    avro::StreamReader r1(*is1);
+    avro::StreamReader r2(*is2);
+    for (size_t i = 0; i < os->byteCount(); ++i) {
+        BOOST_REQUIRE_EQUAL(r1.read(), r2.read());
+    }
+
+    ValidSchema s;
+    ifstream ifs("jsonschemas/bigrecord");
+    compileJsonSchema(ifs, s);
+    unique_ptr<InputStream> is4 = memoryInputStream(*os);
+    d->init(*is4);
+    testgen_f::RootRecord t4;
+    BOOST_REQUIRE(testgen_f::decodeFrom(s.fingerprint(), *d, t4));
+    BOOST_CHECK(t4.mymap == t3.mymap);
+    BOOST_CHECK(t4.myarray == t3.myarray);
+
+    // Static vectors take no more than their capacity.
+    t1.myarray.push_back(1.0);
+    t1.myarray.push_back(2.0);
+    unique_ptr<OutputStream> os3 = memoryOutputStream();
+    e->init(*os3);
+    avro::encode(*e, t1);
+    e->flush();
+    unique_ptr<InputStream> is5 = memoryInputStream(*os3);
+    d->init(*is5);
+    BOOST_CHECK_THROW(avro::decode(*d, t3), avro::Exception);
+    unique_ptr<InputStream> is6 = memoryInputStream(*os3);
+    d->init(*is6);
+    BOOST_CHECK_THROW(testgen_f::decodeFrom(s.fingerprint(), *d, t4), avro::Exception);
+}
+
 template<typename T>
 void testEncoding2() {
     ValidSchema s;
@@ -272,8 +720,16 @@ init_unit_test_suite(int /*argc*/, char * /*argv*/[]) {
     auto *ts = BOOST_TEST_SUITE("Code generator tests");
     ts->add(BOOST_TEST_CASE(testEncoding));
     ts->add(BOOST_TEST_CASE(testResolution));
+    ts->add(BOOST_TEST_CASE(testResolvedDecoder));
+    ts->add(BOOST_TEST_CASE(testEncodedSize));
+    ts->add(BOOST_TEST_CASE(testViews));
+    ts->add(BOOST_TEST_CASE(testCompare));
+    ts->add(BOOST_TEST_CASE(testArrayOrder));
+    ts->add(BOOST_TEST_CASE(testContainers));
     ts->add(BOOST_TEST_CASE(testEncoding2<uau::r1>));
     ts->add(BOOST_TEST_CASE(testEncoding2<umu::r1>));
+    ts->add(BOOST_TEST_CASE(testEmbeddedSchema));
     ts->add(BOOST_TEST_CASE(testNamespace));
+    ts->add(BOOST_TEST_CASE(testTaggedUnions));
     return ts;
 }
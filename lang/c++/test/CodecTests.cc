@@ -25,6 +25,7 @@
 #include "Specific.hh"
 #include "ValidSchema.hh"
 
+#include <algorithm>
 #include <boost/bind.hpp>
 #include <cstdint>
 #include <functional>
@@ -1487,6 +1488,105 @@ static const TestData4 data4[] = {
      {"1", "100", "10.75", nullptr},
      1,
      1},
+
+    // Default values of every primitive type and of a record
+    {R"({"type":"record","name":"r","fields":[
+        {"name":"f0", "type":"int"}]})",
+     "I",
+     {"10", nullptr},
+     R"({"type":"record","name":"r","fields":[
+        {"name":"f0", "type":"int"},
+        {"name":"b", "type":"boolean", "default": true},
+        {"name":"l", "type":"long", "default": 7},
+        {"name":"fl", "type":"float", "default": 1.5},
+        {"name":"d", "type":"double", "default": 2.5},
+        {"name":"s", "type":"string", "default": "hi"},
+        {"name":"by", "type":"bytes", "default": "xy"},
+        {"name":"n", "type":"null", "default": null},
+        {"name":"rec", "type":{"type":"record","name":"inner","fields":[
+            {"name":"a", "type":"int"}, {"name":"t", "type":"string"}]},
+         "default": {"a": 5, "t": "abc"}}]})",
+     "RIBLFDS2b2NIS3",
+     {"10", "1", "7", "1.5", "2.5", "hi", "xy", "5", "abc", nullptr},
+     1,
+     1},
+
+    // Projection skipping runs of fields of every kind
+    {R"({"type":"record","name":"r","fields":[
+        {"name":"f1", "type":"int"},
+        {"name":"f2", "type":"double"},
+        {"name":"f3", "type":"string"},
+        {"name":"f4", "type":{"type":"fixed","name":"fx","size":3}},
+        {"name":"f5", "type":{"type":"enum","name":"en","symbols":["a","b"]}},
+        {"name":"f6", "type":{"type":"array","items":"long"}},
+        {"name":"f7", "type":["null","string"]},
+        {"name":"f8", "type":"boolean"},
+        {"name":"k1", "type":"long"},
+        {"name":"f9", "type":"float"},
+        {"name":"f10", "type":"bytes"},
+        {"name":"f11", "type":{"type":"map","values":"int"}},
+        {"name":"f12", "type":"null"},
+        {"name":"f13", "type":{"type":"record","name":"inner","fields":[
+            {"name":"a", "type":"int"}, {"name":"b", "type":"string"}]}},
+        {"name":"k2", "type":"string"}]})",
+     "IDS5f3e1[c2sLsL]U1S3BLFb2{c1sK1I}NIS1S2",
+     {"10", "1.5", "hello", "abc", "5", "6", "xyz", "1", "100",
+      "2.5", "bb", "k", "7", "8", "c", "s2", nullptr},
+     R"({"type":"record","name":"r","fields":[
+        {"name":"k1", "type":"long"},
+        {"name":"k2", "type":"string"}]})",
+     "RLS2",
+     {"100", "s2", nullptr},
+     1,
+     1},
+
+    // Record plans: drops, promotions, a nested plan, recursion through an
+    // array and a default, all in one record
+    {R"({"type":"record","name":"r","fields":[
+        {"name":"a", "type":"int"},
+        {"name":"x", "type":"string"},
+        {"name":"b", "type":"float"},
+        {"name":"in", "type":{"type":"record","name":"inner","fields":[
+            {"name":"p", "type":"int"}, {"name":"q", "type":"long"}]}},
+        {"name":"kids", "type":{"type":"array","items":"r"}},
+        {"name":"y", "type":"boolean"}]})",
+     "IS5FIL[c1sIS5FIL[]B]B",
+     {"10", "hello", "1.5", "3", "4", "11", "world", "2.5", "5", "6", "0", "1", nullptr},
+     R"({"type":"record","name":"r","fields":[
+        {"name":"a", "type":"long"},
+        {"name":"b", "type":"double"},
+        {"name":"in", "type":{"type":"record","name":"inner","fields":[
+            {"name":"p", "type":"int"}]}},
+        {"name":"kids", "type":{"type":"array","items":"r"}},
+        {"name":"z", "type":"string", "default": "zz"}]})",
+     "RLDRI[c1sRLDRI[]S2]S2",
+     {"10", "1.5", "3", "11", "2.5", "5", "zz", "zz", nullptr},
+     2,
+     1},
+
+    // Projection skipping fixed-width runs, including a nested record
+    {R"({"type":"record","name":"r","fields":[
+        {"name":"f1", "type":"double"},
+        {"name":"f2", "type":"float"},
+        {"name":"f3", "type":"boolean"},
+        {"name":"f4", "type":{"type":"fixed","name":"fx","size":5}},
+        {"name":"f5", "type":"null"},
+        {"name":"f6", "type":{"type":"record","name":"point","fields":[
+            {"name":"x", "type":"double"}, {"name":"y", "type":"double"}]}},
+        {"name":"k1", "type":"int"},
+        {"name":"f7", "type":"point"},
+        {"name":"f8", "type":"fx"},
+        {"name":"f9", "type":"string"},
+        {"name":"f10", "type":"float"}]})",
+     "DFBf5NDDIDDf5S3F",
+     {"1.5", "2.5", "1", "abcde", "3.5", "4.5", "10", "5.5", "6.5",
+      "vwxyz", "str", "7.5", nullptr},
+     R"({"type":"record","name":"r","fields":[
+        {"name":"k1", "type":"int"}]})",
+     "RI",
+     {"10", nullptr},
+     1,
+     1},
 };
 
 static const TestData4 data4BinaryOnly[] = {
@@ -1777,6 +1877,475 @@ static void testJsonCodecReinit() {
     }
 }
 
+static void testResolvingDecoderReinitInArray() {
+    const char *schemaStr = "{\"type\":\"array\",\"items\":"
+                            "{\"type\":\"array\",\"items\":\"long\"}}";
+    ValidSchema schema = parsing::makeValidSchema(schemaStr);
+    OutputStreamPtr os = memoryOutputStream();
+    {
+        EncoderPtr e = binaryEncoder();
+        e->init(*os);
+        e->arrayStart();
+        e->setItemCount(2);
+        e->startItem();
+        e->arrayStart();
+        e->setItemCount(2);
+        e->startItem();
+        e->encodeLong(1);
+        e->startItem();
+        e->encodeLong(2);
+        e->arrayEnd();
+        e->startItem();
+        e->arrayStart();
+        e->setItemCount(1);
+        e->startItem();
+        e->encodeLong(3);
+        e->arrayEnd();
+        e->arrayEnd();
+        e->flush();
+    }
+
+    DecoderPtr d = resolvingDecoder(schema, schema, binaryDecoder());
+    // Abandon the first parse in the middle of the inner array; the
+    // pending item counts must not leak into the next one.
+    InputStreamPtr is1 = memoryInputStream(*os);
+    d->init(*is1);
+    BOOST_CHECK_EQUAL(d->arrayStart(), 2);
+    BOOST_CHECK_EQUAL(d->arrayStart(), 2);
+    BOOST_CHECK_EQUAL(d->decodeLong(), 1);
+
+    for (int i = 0; i < 2; ++i) {
+        InputStreamPtr is = memoryInputStream(*os);
+        d->init(*is);
+        BOOST_CHECK_EQUAL(d->arrayStart(), 2);
+        BOOST_CHECK_EQUAL(d->arrayStart(), 2);
+        BOOST_CHECK_EQUAL(d->decodeLong(), 1);
+        BOOST_CHECK_EQUAL(d->decodeLong(), 2);
+        BOOST_CHECK_EQUAL(d->arrayNext(), 0);
+        BOOST_CHECK_EQUAL(d->arrayStart(), 1);
+        BOOST_CHECK_EQUAL(d->decodeLong(), 3);
+        BOOST_CHECK_EQUAL(d->arrayNext(), 0);
+        BOOST_CHECK_EQUAL(d->arrayNext(), 0);
+    }
+}
+
+static void encodeNestedArrays(Encoder &e, size_t blocks) {
+    e.arrayStart();
+    for (size_t b = 0; b < blocks; ++b) {
+        e.setItemCount(2);
+        for (int i = 0; i < 2; ++i) {
+            e.startItem();
+            e.arrayStart();
+            e.setItemCount(3);
+            for (int j = 0; j < 3; ++j) {
+                e.startItem();
+                e.encodeLong(j);
+                e.encodeString("item");
+            }
+            e.arrayEnd();
+        }
+    }
+    e.arrayEnd();
+    e.encodeInt(1234);
+}
+
+static void testBlockingBinaryEncoder() {
+    const size_t maxBufferSizes[] = {64 * 1024, 30, 1};
+    for (size_t maxBufferSize : maxBufferSizes) {
+        OutputStreamPtr os = memoryOutputStream();
+        EncoderPtr e = blockingBinaryEncoder(maxBufferSize);
+        e->init(*os);
+        encodeNestedArrays(*e, 3);
+        encodeNestedArrays(*e, 1);
+        e->flush();
+
+        InputStreamPtr is = memoryInputStream(*os);
+        DecoderPtr d = binaryDecoder();
+        d->init(*is);
+        for (size_t b = 0, n = d->arrayStart(); n != 0; n = d->arrayNext(), ++b) {
+            BOOST_CHECK_EQUAL(n, 2);
+            for (size_t i = 0; i < n; ++i) {
+                size_t total = 0;
+                for (size_t m = d->arrayStart(); m != 0; m = d->arrayNext()) {
+                    for (size_t j = 0; j < m; ++j) {
+                        BOOST_CHECK_EQUAL(d->decodeLong(), j);
+                        BOOST_CHECK_EQUAL(d->decodeString(), "item");
+                    }
+                    total += m;
+                }
+                BOOST_CHECK_EQUAL(total, 3);
+            }
+            BOOST_CHECK(b < 3);
+        }
+        BOOST_CHECK_EQUAL(d->decodeInt(), 1234);
+
+        // Sized blocks are skipped in one go; the others are handed back
+        // to the caller.
+        size_t n = d->skipArray();
+        if (maxBufferSize > 100) {
+            BOOST_CHECK_EQUAL(n, 0);
+        } else {
+            BOOST_CHECK_EQUAL(n, 2);
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t m = d->skipArray(); m != 0; m = d->arrayNext()) {
+                    for (size_t j = 0; j < m; ++j) {
+                        d->decodeLong();
+                        d->skipString();
+                    }
+                }
+            }
+            BOOST_CHECK_EQUAL(d->arrayNext(), 0);
+        }
+        BOOST_CHECK_EQUAL(d->decodeInt(), 1234);
+    }
+}
+
+static void testGenericDatumScalars() {
+    GenericDatum b(true);
+    GenericDatum i(int32_t(-5));
+    GenericDatum l(int64_t(1) << 40);
+    GenericDatum f(1.5f);
+    GenericDatum d(2.25);
+    BOOST_CHECK_EQUAL(b.type(), AVRO_BOOL);
+    BOOST_CHECK_EQUAL(b.value<bool>(), true);
+    BOOST_CHECK_EQUAL(i.value<int32_t>(), -5);
+    BOOST_CHECK_EQUAL(l.value<int64_t>(), int64_t(1) << 40);
+    BOOST_CHECK_EQUAL(f.value<float>(), 1.5f);
+    BOOST_CHECK_EQUAL(d.value<double>(), 2.25);
+
+    GenericDatum copy = l;
+    copy.value<int64_t>() = 7;
+    BOOST_CHECK_EQUAL(copy.value<int64_t>(), 7);
+    BOOST_CHECK_EQUAL(l.value<int64_t>(), int64_t(1) << 40);
+
+    ValidSchema s = parsing::makeValidSchema(
+        R"(["null", "double", {"type":"int","logicalType":"date"}])");
+    GenericDatum u(s);
+    BOOST_CHECK_EQUAL(u.type(), AVRO_NULL);
+    u.selectBranch(1);
+    u.value<double>() = 3.5;
+    GenericDatum u2 = u;
+    BOOST_CHECK_EQUAL(u2.type(), AVRO_DOUBLE);
+    BOOST_CHECK_EQUAL(u2.value<double>(), 3.5);
+    u2.selectBranch(2);
+    BOOST_CHECK_EQUAL(u2.type(), AVRO_INT);
+    BOOST_CHECK_EQUAL(u2.value<int32_t>(), 0);
+    BOOST_CHECK_EQUAL(u.value<double>(), 3.5);
+
+    GenericDatum date(s.root()->leafAt(2), int32_t(19000));
+    BOOST_CHECK(date.logicalType().type() == LogicalType::DATE);
+    BOOST_CHECK_EQUAL(date.value<int32_t>(), 19000);
+
+    const GenericDatum &ci = i;
+    BOOST_CHECK_THROW(i.value<int64_t>(), Exception);
+    BOOST_CHECK_THROW(ci.value<int64_t>(), Exception);
+    BOOST_CHECK_THROW(l.value<int32_t>(), Exception);
+    BOOST_CHECK_THROW(d.value<float>(), Exception);
+    BOOST_CHECK_THROW(b.value<int32_t>(), Exception);
+    BOOST_CHECK_THROW(GenericDatum(std::string("x")).value<int32_t>(), Exception);
+    BOOST_CHECK_THROW(u2.value<double>(), Exception);
+    ValidSchema ls = parsing::makeValidSchema(R"("long")");
+    BOOST_CHECK_THROW(GenericDatum(ls.root(), int32_t(-1)), Exception);
+}
+
+static void testGenericReaderReuse() {
+    const char *writerSchema = R"({"type":"record","name":"R","fields":[
+        {"name":"extra","type":"int"},
+        {"name":"name","type":"string"},
+        {"name":"tags","type":{"type":"array","items":
+            {"type":"record","name":"T","fields":[
+                {"name":"k","type":"string"},
+                {"name":"v","type":["null","long"]}]}}},
+        {"name":"m","type":{"type":"map","values":"int"}}]})";
+    const char *readerSchema = R"({"type":"record","name":"R","fields":[
+        {"name":"m","type":{"type":"map","values":"int"}},
+        {"name":"name","type":"string"},
+        {"name":"tags","type":{"type":"array","items":
+            {"type":"record","name":"T","fields":[
+                {"name":"k","type":"string"},
+                {"name":"v","type":["null","long"]}]}}}]})";
+    ValidSchema wvs = parsing::makeValidSchema(writerSchema);
+    ValidSchema rvs = parsing::makeValidSchema(readerSchema);
+    const std::string names[] = {
+        "a name that does not fit in the small string buffer", "short", "x"};
+    const size_t tagCounts[] = {3, 2, 3};
+
+    OutputStreamPtr os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    for (size_t i = 0; i < 3; ++i) {
+        GenericDatum w(wvs);
+        GenericRecord &r = w.value<GenericRecord>();
+        r.field("extra") = GenericDatum(int32_t(i));
+        r.field("name").value<std::string>() = names[i];
+        GenericArray &a = r.field("tags").value<GenericArray>();
+        for (size_t j = 0; j < tagCounts[i]; ++j) {
+            GenericDatum t(a.schema()->leafAt(0));
+            GenericRecord &tr = t.value<GenericRecord>();
+            tr.field("k").value<std::string>() = std::to_string(j);
+            if (j % 2 == 1) {
+                tr.field("v").selectBranch(1);
+                tr.field("v").value<int64_t>() = int64_t(i * 10 + j);
+            }
+            a.value().push_back(t);
+        }
+        r.field("m").value<GenericMap>().value().emplace_back(
+            "k", GenericDatum(int32_t(i)));
+        avro::encode(*e, w);
+    }
+    e->flush();
+
+    InputStreamPtr is = memoryInputStream(*os);
+    DecoderPtr d = binaryDecoder();
+    d->init(*is);
+    GenericReader reader(wvs, rvs, d);
+    GenericDatum datum;
+    const char *nameData = nullptr;
+    const GenericDatum *firstTag = nullptr;
+    for (size_t i = 0; i < 3; ++i) {
+        reader.readInto(datum);
+        GenericRecord &r = datum.value<GenericRecord>();
+        const std::string &name = r.field("name").value<std::string>();
+        const GenericArray::Value &tags =
+            r.field("tags").value<GenericArray>().value();
+        BOOST_CHECK_EQUAL(name, names[i]);
+        BOOST_REQUIRE_EQUAL(tags.size(), tagCounts[i]);
+        for (size_t j = 0; j < tags.size(); ++j) {
+            const GenericRecord &tr = tags[j].value<GenericRecord>();
+            BOOST_CHECK_EQUAL(tr.field("k").value<std::string>(),
+                              std::to_string(j));
+            BOOST_CHECK_EQUAL(tr.field("v").unionBranch(), j % 2);
+            if (j % 2 == 1) {
+                BOOST_CHECK_EQUAL(tr.field("v").value<int64_t>(),
+                                  int64_t(i * 10 + j));
+            }
+        }
+        const GenericMap::Value &m = r.field("m").value<GenericMap>().value();
+        BOOST_REQUIRE_EQUAL(m.size(), 1);
+        BOOST_CHECK_EQUAL(m[0].second.value<int32_t>(), int32_t(i));
+        if (i == 0) {
+            nameData = name.data();
+            firstTag = &tags[0];
+        } else {
+            BOOST_CHECK(name.data() == nameData);
+            BOOST_CHECK(&tags[0] == firstTag);
+        }
+    }
+}
+
+static void testGenericReaderOtherSchema() {
+    // A datum of the same type but built for another schema is rebuilt
+    // rather than decoded with its own layout.
+    ValidSchema s = parsing::makeValidSchema(R"({"type":"record","name":"R",
+        "fields":[{"name":"a","type":"long"},{"name":"b","type":"string"}]})");
+    ValidSchema o = parsing::makeValidSchema(R"({"type":"record","name":"O",
+        "fields":[{"name":"x","type":"string"}]})");
+    ValidSchema us = parsing::makeValidSchema(R"(["null","long"])");
+    ValidSchema uo = parsing::makeValidSchema(R"(["null","string"])");
+
+    OutputStreamPtr os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    GenericDatum w(s);
+    w.value<GenericRecord>().field("a") = GenericDatum(int64_t(7));
+    w.value<GenericRecord>().field("b").value<std::string>() = "seven";
+    avro::encode(*e, w);
+    GenericDatum wu(us);
+    wu.selectBranch(1);
+    wu.value<int64_t>() = 8;
+    avro::encode(*e, wu);
+    e->flush();
+
+    InputStreamPtr is = memoryInputStream(*os);
+    DecoderPtr d = binaryDecoder();
+    d->init(*is);
+    GenericReader reader(s, d);
+    GenericDatum datum(o);
+    reader.readInto(datum);
+    const GenericRecord &r = datum.value<GenericRecord>();
+    BOOST_CHECK(r.schema() == s.root());
+    BOOST_CHECK_EQUAL(r.field("a").value<int64_t>(), 7);
+    BOOST_CHECK_EQUAL(r.field("b").value<std::string>(), "seven");
+
+    GenericReader ureader(us, d);
+    GenericDatum u(uo);
+    ureader.readInto(u);
+    BOOST_CHECK(u.unionSchema() == us.root());
+    BOOST_REQUIRE_EQUAL(u.unionBranch(), 1);
+    BOOST_CHECK_EQUAL(u.value<int64_t>(), 8);
+}
+
+static void testGenericReaderRelease() {
+    ValidSchema s = parsing::makeValidSchema(R"({"type":"record","name":"R",
+        "fields":[
+            {"name":"items","type":{"type":"array","items":
+                ["string",{"type":"record","name":"P","fields":[
+                    {"name":"x","type":"long"},{"name":"y","type":"string"}]}]}},
+            {"name":"attrs","type":{"type":"map","values":"bytes"}}]})");
+    const size_t counts[] = {4, 1, 0, 6, 2, 5};
+    const size_t batchSize = 3;
+
+    OutputStreamPtr os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    for (size_t i = 0; i < 2 * batchSize; ++i) {
+        GenericDatum w(s);
+        GenericRecord &r = w.value<GenericRecord>();
+        GenericArray &a = r.field("items").value<GenericArray>();
+        GenericMap &m = r.field("attrs").value<GenericMap>();
+        for (size_t j = 0; j < counts[i]; ++j) {
+            GenericDatum u(a.schema()->leafAt(0));
+            if ((i + j) % 2 == 0) {
+                u.value<std::string>() = "item " + std::to_string(j);
+            } else {
+                u.selectBranch(1);
+                GenericRecord &p = u.value<GenericRecord>();
+                p.field("x") = GenericDatum(int64_t(i * 100 + j));
+                p.field("y").value<std::string>() = std::to_string(i);
+            }
+            a.value().push_back(u);
+            GenericDatum b(m.schema()->leafAt(1));
+            b.value<std::vector<uint8_t>>().assign(j, uint8_t(i));
+            m.value().emplace_back(std::to_string(j), b);
+        }
+        avro::encode(*e, w);
+    }
+    e->flush();
+
+    InputStreamPtr is = memoryInputStream(*os);
+    DecoderPtr d = binaryDecoder();
+    d->init(*is);
+    GenericReader reader(s, d);
+    std::vector<GenericDatum> batch(batchSize);
+    std::vector<const GenericRecord *> roots;
+    for (size_t k = 0; k < 2; ++k) {
+        std::vector<const GenericRecord *> current;
+        for (size_t n = 0; n < batchSize; ++n) {
+            size_t i = k * batchSize + n;
+            reader.readInto(batch[n]);
+            const GenericRecord &r = batch[n].value<GenericRecord>();
+            current.push_back(&r);
+            const GenericArray::Value &a =
+                r.field("items").value<GenericArray>().value();
+            const GenericMap::Value &m =
+                r.field("attrs").value<GenericMap>().value();
+            BOOST_REQUIRE_EQUAL(a.size(), counts[i]);
+            BOOST_REQUIRE_EQUAL(m.size(), counts[i]);
+            for (size_t j = 0; j < counts[i]; ++j) {
+                if ((i + j) % 2 == 0) {
+                    BOOST_CHECK_EQUAL(a[j].unionBranch(), 0);
+                    BOOST_CHECK_EQUAL(a[j].value<std::string>(),
+                                      "item " + std::to_string(j));
+                } else {
+                    BOOST_CHECK_EQUAL(a[j].unionBranch(), 1);
+                    const GenericRecord &p = a[j].value<GenericRecord>();
+                    BOOST_CHECK_EQUAL(p.field("x").value<int64_t>(),
+                                      int64_t(i * 100 + j));
+                    BOOST_CHECK_EQUAL(p.field("y").value<std::string>(),
+                                      std::to_string(i));
+                }
+                BOOST_CHECK_EQUAL(m[j].first, std::to_string(j));
+                BOOST_CHECK(m[j].second.value<std::vector<uint8_t>>() == std::vector<uint8_t>(j, uint8_t(i)));
+            }
+        }
+        for (GenericDatum &datum : batch) {
+            reader.release(datum);
+            BOOST_CHECK_EQUAL(datum.type(), AVRO_NULL);
+        }
+        std::sort(current.begin(), current.end());
+        if (k == 0) {
+            roots = current;
+        } else {
+            // The second batch lives in the records of the first one.
+            BOOST_CHECK(current == roots);
+        }
+    }
+
+    // The memory kept for reuse can be given back.
+    BOOST_CHECK(reader.pooled() >= batchSize);
+    reader.clearPool();
+    BOOST_CHECK_EQUAL(reader.pooled(), 0);
+    InputStreamPtr again = memoryInputStream(*os);
+    d->init(*again);
+    GenericDatum fresh;
+    reader.readInto(fresh);
+    BOOST_CHECK_EQUAL(fresh.value<GenericRecord>().field("items").value<GenericArray>().value().size(), counts[0]);
+}
+
+static void testGenericMapFind() {
+    ValidSchema s = parsing::makeValidSchema(R"({"type":"map","values":"int"})");
+    const size_t sizes[] = {0, 3, 15, 16, 300};
+    for (size_t size : sizes) {
+        GenericDatum datum(s);
+        GenericMap &m = datum.value<GenericMap>();
+        for (size_t i = 0; i < size; ++i) {
+            m.value().emplace_back("key" + std::to_string(i), GenericDatum(int32_t(i)));
+        }
+        const GenericMap &cm = m;
+        // Const lookups scan until the index is built, and then use it.
+        for (int indexed = 0; indexed < 2; ++indexed) {
+            for (size_t i = 0; i < size; ++i) {
+                GenericMap::Value::const_iterator it = cm.find("key" + std::to_string(i));
+                BOOST_REQUIRE(it != cm.value().end());
+                BOOST_CHECK_EQUAL(it - cm.value().begin(), i);
+                BOOST_CHECK_EQUAL(it->second.value<int32_t>(), int32_t(i));
+            }
+            BOOST_CHECK(!cm.contains("missing"));
+            m.buildIndex();
+        }
+
+        // Adding entries after a lookup is seen by the next one.
+        m.value().emplace_back("new", GenericDatum(int32_t(-1)));
+        BOOST_CHECK(m.contains("new"));
+        m.find("new")->second.value<int32_t>() = -2;
+        BOOST_CHECK_EQUAL(cm.find("new")->second.value<int32_t>(), -2);
+
+        // The first of duplicate keys is found.
+        m.value().emplace_back("key0", GenericDatum(int32_t(-3)));
+        BOOST_CHECK_EQUAL(cm.find("key0")->second.value<int32_t>(), size == 0 ? -3 : 0);
+
+        // Keys changed in place.
+        if (size > 0) {
+            m.value()[0].first = "renamed";
+            BOOST_CHECK(m.contains("renamed"));
+            BOOST_CHECK_EQUAL(m.find("key0")->second.value<int32_t>(), -3);
+        }
+        GenericDatum copy = datum;
+        BOOST_CHECK(copy.value<GenericMap>().contains("new"));
+    }
+}
+
+static void testAsResolvingDecoder() {
+    ValidSchema s = parsing::makeValidSchema(R"({"type":"record","name":"R","fields":[{"name":"f","type":"int"}]})");
+    BOOST_CHECK(binaryDecoder()->asResolvingDecoder() == nullptr);
+    BOOST_CHECK(validatingDecoder(s, binaryDecoder())->asResolvingDecoder() == nullptr);
+    ResolvingDecoderPtr rd = resolvingDecoder(s, s, binaryDecoder());
+    Decoder &d = *rd;
+    BOOST_CHECK(d.asResolvingDecoder() == rd.get());
+}
+
+static void testEncodeStringSpan() {
+    ValidSchema schema = parsing::makeValidSchema(R"("string")");
+    EncoderPtr encoders[][2] = {
+        {binaryEncoder(), binaryEncoder()},
+        {validatingEncoder(schema, binaryEncoder()), validatingEncoder(schema, binaryEncoder())},
+        {jsonEncoder(schema), jsonEncoder(schema)}};
+    const std::string str = "a string";
+    for (auto &pair : encoders) {
+        OutputStreamPtr os1 = memoryOutputStream();
+        OutputStreamPtr os2 = memoryOutputStream();
+        pair[0]->init(*os1);
+        pair[0]->encodeString(str);
+        pair[0]->flush();
+        pair[1]->init(*os2);
+        pair[1]->encodeString(str.data(), str.size());
+        pair[1]->flush();
+        std::shared_ptr<std::vector<uint8_t>> b1 = snapshot(*os1);
+        std::shared_ptr<std::vector<uint8_t>> b2 = snapshot(*os2);
+        BOOST_CHECK(*b1 == *b2);
+    }
+}
+
 static void testByteCount() {
     OutputStreamPtr os1 = memoryOutputStream();
     EncoderPtr e1 = binaryEncoder();
@@ -1788,6 +2357,48 @@ static void testByteCount() {
     BOOST_CHECK_EQUAL(os1->byteCount(), 3);
 }
 
+static void testVarintChunkBoundaries() {
+    const int64_t values[] = {
+        0, 1, -1, 63, -64, 64, -65, 8191, -8192,
+        std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min(),
+        std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min()};
+    const size_t count = sizeof(values) / sizeof(values[0]);
+
+    // Small chunks force varints to straddle chunk boundaries while the
+    // large ones let them be encoded and decoded in place.
+    const size_t chunkSizes[] = {1, 3, 7, 11, 4096};
+    for (size_t chunkSize : chunkSizes) {
+        OutputStreamPtr os = memoryOutputStream(chunkSize);
+        EncoderPtr e = binaryEncoder();
+        e->init(*os);
+        for (size_t i = 0; i < count; ++i) {
+            e->encodeLong(values[i]);
+            e->encodeDouble(static_cast<double>(i));
+        }
+        e->flush();
+
+        std::shared_ptr<std::vector<uint8_t>> v = snapshot(*os);
+        InputStreamPtr chunked = memoryInputStream(*os);
+        InputStreamPtr contiguous = memoryInputStream(v->data(), v->size());
+        InputStream *inputs[] = {chunked.get(), contiguous.get()};
+        for (InputStream *is : inputs) {
+            DecoderPtr d = binaryDecoder();
+            d->init(*is);
+            for (size_t i = 0; i < count; ++i) {
+                BOOST_CHECK_EQUAL(d->decodeLong(), values[i]);
+                BOOST_CHECK_EQUAL(d->decodeDouble(), static_cast<double>(i));
+            }
+        }
+    }
+
+    const uint8_t invalid[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                               0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+    InputStreamPtr is = memoryInputStream(invalid, sizeof(invalid));
+    DecoderPtr d = binaryDecoder();
+    d->init(*is);
+    BOOST_CHECK_THROW(d->decodeLong(), Exception);
+}
+
 } // namespace avro
 
 boost::unit_test::test_suite *
@@ -1803,6 +2414,16 @@ init_unit_test_suite(int argc, char *argv[]) {
                                   ENDOF(avro::jsonData)));
     ts->add(BOOST_TEST_CASE(avro::testJsonCodecReinit));
     ts->add(BOOST_TEST_CASE(avro::testByteCount));
+    ts->add(BOOST_TEST_CASE(avro::testEncodeStringSpan));
+    ts->add(BOOST_TEST_CASE(avro::testResolvingDecoderReinitInArray));
+    ts->add(BOOST_TEST_CASE(avro::testVarintChunkBoundaries));
+    ts->add(BOOST_TEST_CASE(avro::testGenericDatumScalars));
+    ts->add(BOOST_TEST_CASE(avro::testGenericReaderReuse));
+    ts->add(BOOST_TEST_CASE(avro::testGenericReaderOtherSchema));
+    ts->add(BOOST_TEST_CASE(avro::testGenericReaderRelease));
+    ts->add(BOOST_TEST_CASE(avro::testGenericMapFind));
+    ts->add(BOOST_TEST_CASE(avro::testAsResolvingDecoder));
+    ts->add(BOOST_TEST_CASE(avro::testBlockingBinaryEncoder));
 
     return ts;
 }
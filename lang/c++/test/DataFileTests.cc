@@ -773,6 +773,87 @@ void testSkipStringSnappyCodec() {
 }
 #endif
 
+struct ArrayWriterObj {
+    std::vector<int64_t> v;
+    std::string s2;
+};
+
+namespace avro {
+template<>
+struct codec_traits<ArrayWriterObj> {
+    static void encode(Encoder &e, const ArrayWriterObj &v) {
+        avro::encode(e, v.v);
+        avro::encode(e, v.s2);
+    }
+
+    static void decode(Decoder &d, ArrayWriterObj &v) {
+        avro::decode(d, v.v);
+        avro::decode(d, v.s2);
+    }
+};
+} // namespace avro
+
+void testSizedBlocks(avro::Codec codec) {
+    const char *writerSchemaStr = "{"
+                                  "\"type\": \"record\", \"name\": \"R\", \"fields\":["
+                                  "{\"name\": \"v\", \"type\": {\"type\": \"array\", \"items\": \"long\"}},"
+                                  "{\"name\": \"s2\", \"type\": \"string\"}"
+                                  "]}";
+    const char *readerSchemaStr = "{"
+                                  "\"type\": \"record\", \"name\": \"R\", \"fields\":["
+                                  "{\"name\": \"s2\", \"type\": \"string\"}"
+                                  "]}";
+    avro::ValidSchema writerSchema =
+        avro::compileJsonSchemaFromString(writerSchemaStr);
+    avro::ValidSchema readerSchema =
+        avro::compileJsonSchemaFromString(readerSchemaStr);
+
+    ArrayWriterObj w;
+    for (int64_t i = 0; i < 1000; ++i) {
+        w.v.push_back(i * 1000);
+    }
+    const char *filename = "test_sized_blocks.df";
+    {
+        avro::DataFileWriter<ArrayWriterObj> df(filename,
+                                                writerSchema, 100, codec, true);
+        w.s2 = "b1";
+        df.write(w);
+        w.s2 = "b2";
+        df.write(w);
+        df.close();
+    }
+    {
+        avro::DataFileReader<ArrayWriterObj> df(filename);
+        ArrayWriterObj ro;
+        BOOST_CHECK_EQUAL(df.read(ro), true);
+        BOOST_CHECK(ro.v == w.v);
+        BOOST_CHECK_EQUAL(ro.s2, "b1");
+        BOOST_CHECK_EQUAL(df.read(ro), true);
+        BOOST_CHECK_EQUAL(ro.s2, "b2");
+        BOOST_CHECK_EQUAL(df.read(ro), false);
+    }
+    {
+        avro::DataFileReader<ReaderObj> df(filename, readerSchema);
+        ReaderObj ro("");
+        BOOST_CHECK_EQUAL(df.read(ro), true);
+        BOOST_CHECK_EQUAL(ro.s2, "b1");
+        BOOST_CHECK_EQUAL(df.read(ro), true);
+        BOOST_CHECK_EQUAL(ro.s2, "b2");
+        BOOST_CHECK_EQUAL(df.read(ro), false);
+    }
+    boost::filesystem::remove(filename);
+}
+
+void testSizedBlocksNullCodec() {
+    BOOST_TEST_CHECKPOINT(__func__);
+    testSizedBlocks(avro::NULL_CODEC);
+}
+
+void testSizedBlocksDeflateCodec() {
+    BOOST_TEST_CHECKPOINT(__func__);
+    testSizedBlocks(avro::DEFLATE_CODEC);
+}
+
 struct TestRecord {
     std::string s1;
     int64_t id;
@@ -1132,6 +1213,9 @@ init_unit_test_suite(int argc, char *argv[]) {
     boost::unit_test::framework::master_test_suite().add(BOOST_TEST_CASE(&testSkipStringSnappyCodec));
 #endif
 
+    boost::unit_test::framework::master_test_suite().add(BOOST_TEST_CASE(&testSizedBlocksNullCodec));
+    boost::unit_test::framework::master_test_suite().add(BOOST_TEST_CASE(&testSizedBlocksDeflateCodec));
+
     boost::unit_test::framework::master_test_suite().add(BOOST_TEST_CASE(&testLastSyncNullCodec));
     boost::unit_test::framework::master_test_suite().add(BOOST_TEST_CASE(&testLastSyncDeflateCodec));
 #ifdef SNAPPY_CODEC_AVAILABLE
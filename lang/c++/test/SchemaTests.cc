@@ -150,8 +150,10 @@ const char *basicSchemaErrors[] = {
     // default double - null
     R"({ "name":"test", "type": "record", "fields": [ {"name": "double","type": "double","default" : null }]})",
     // default double - string
-    R"({ "name":"test", "type": "record", "fields": [ {"name": "double","type": "double","default" : "string" }]})"
+    R"({ "name":"test", "type": "record", "fields": [ {"name": "double","type": "double","default" : "string" }]})",
 
+    // Unknown field order
+    R"({ "name":"test", "type": "record", "fields": [ {"name": "f","type": "long","order" : "sideways" }]})"
 };
 
 const char *roundTripSchemas[] = {
@@ -170,6 +172,10 @@ const char *roundTripSchemas[] = {
     "{\"type\":\"record\",\"name\":\"Test\",\"fields\":"
     "[{\"name\":\"f1\",\"type\":\"long\"},"
     "{\"name\":\"f2\",\"type\":\"int\"}]}",
+    // Field order
+    "{\"type\":\"record\",\"name\":\"Test\",\"fields\":"
+    "[{\"name\":\"f1\",\"type\":\"long\",\"order\":\"descending\"},"
+    "{\"name\":\"f2\",\"type\":\"int\",\"order\":\"ignore\"}]}",
     /* Avro-C++ cannot do a round-trip on error schemas.
  * "{\"type\":\"error\",\"name\":\"Test\",\"fields\":"
  *       "[{\"name\":\"f1\",\"type\":\"long\"},"
@@ -447,6 +453,90 @@ static void testMalformedLogicalTypes(const char *schema) {
     BOOST_CHECK(datum.logicalType().type() == LogicalType::NONE);
 }
 
+static void testNameIndex() {
+    std::string schema = R"({"type":"record","name":"R","fields":[)";
+    std::string symbols;
+    const size_t count = 200;
+    for (size_t i = 0; i < count; ++i) {
+        schema += (i == 0 ? "" : ",") + std::string(R"({"name":"f)") + std::to_string(i) + R"(","type":"int"})";
+        symbols += (i == 0 ? "" : ",") + std::string("\"S") + std::to_string(i) + "\"";
+    }
+    schema += "]}";
+    ValidSchema record = compileJsonSchemaFromString(schema);
+    ValidSchema e = compileJsonSchemaFromString(
+        R"({"type":"enum","name":"E","symbols":[)" + symbols + "]}");
+    for (size_t i = 0; i < count; ++i) {
+        size_t index = count;
+        BOOST_CHECK(record.root()->nameIndex("f" + std::to_string(i), index));
+        BOOST_CHECK_EQUAL(index, i);
+        BOOST_CHECK(e.root()->nameIndex("S" + std::to_string(i), index));
+        BOOST_CHECK_EQUAL(index, i);
+    }
+    size_t index = 0;
+    BOOST_CHECK(!record.root()->nameIndex("f200", index));
+    BOOST_CHECK(!record.root()->nameIndex("", index));
+    BOOST_CHECK(!e.root()->nameIndex("f1", index));
+}
+
+static void testFieldPath() {
+    ValidSchema s = compileJsonSchemaFromString(R"({"type":"record","name":"A",
+        "fields":[
+            {"name":"x","type":"int"},
+            {"name":"b","type":{"type":"record","name":"B","fields":[
+                {"name":"y","type":"string"},
+                {"name":"c","type":{"type":"record","name":"C","fields":[
+                    {"name":"z","type":"long"}]}}]}},
+            {"name":"d","type":"B"}]})");
+    GenericDatum datum(s);
+    GenericRecord &r = datum.value<GenericRecord>();
+
+    GenericFieldPath z(s.root(), "b.c.z");
+    BOOST_CHECK(z.indices() == std::vector<size_t>({1, 1, 0}));
+    z.get(r).value<int64_t>() = 42;
+    BOOST_CHECK_EQUAL(r.field("b").value<GenericRecord>().field("c").value<GenericRecord>().field("z").value<int64_t>(), 42);
+
+    GenericFieldPath dz(s.root(), "d.c.z");
+    dz.get(r).value<int64_t>() = 7;
+    const GenericRecord &cr = r;
+    BOOST_CHECK_EQUAL(dz.get(cr).value<int64_t>(), 7);
+    BOOST_CHECK_EQUAL(z.get(cr).value<int64_t>(), 42);
+
+    GenericFieldPath x(s.root(), "x");
+    BOOST_CHECK(x.indices() == std::vector<size_t>(1, 0));
+    BOOST_CHECK_EQUAL(x.get(cr).type(), AVRO_INT);
+
+    BOOST_CHECK_THROW(GenericFieldPath(s.root(), "b.w"), Exception);
+    BOOST_CHECK_THROW(GenericFieldPath(s.root(), "x.y"), Exception);
+    BOOST_CHECK_THROW(GenericFieldPath(s.root(), "b."), Exception);
+}
+
+static void testCanonicalForm() {
+    // Fingerprints from the Avro specification's test data.
+    BOOST_CHECK_EQUAL(compileJsonSchemaFromString("\"null\"").fingerprint(),
+                      7195948357588979594ULL);
+    BOOST_CHECK_EQUAL(compileJsonSchemaFromString("{\"type\": \"int\"}").fingerprint(),
+                      8247732601305521295ULL);
+
+    ValidSchema s = compileJsonSchemaFromString(R"({"type":"record","name":"R",
+        "namespace":"x.y","doc":"dropped","fields":[
+            {"name":"a","type":{"type":"long","logicalType":"timestamp-millis"},
+                "default":0},
+            {"name":"f","type":{"type":"fixed","size":4,"name":"F"}},
+            {"name":"e","type":{"type":"enum","name":"E","symbols":["A","B"]}},
+            {"name":"m","type":{"type":"map","values":{"type":"array","items":"F"}}},
+            {"name":"n","type":["null","R"]}]})");
+    BOOST_CHECK_EQUAL(s.toCanonicalJson(),
+                      "{\"name\":\"x.y.R\",\"type\":\"record\",\"fields\":["
+                      "{\"name\":\"a\",\"type\":\"long\"},"
+                      "{\"name\":\"f\",\"type\":{\"name\":\"x.y.F\",\"type\":\"fixed\",\"size\":4}},"
+                      "{\"name\":\"e\",\"type\":{\"name\":\"x.y.E\",\"type\":\"enum\",\"symbols\":[\"A\",\"B\"]}},"
+                      "{\"name\":\"m\",\"type\":{\"type\":\"map\",\"values\":"
+                      "{\"type\":\"array\",\"items\":\"x.y.F\"}}},"
+                      "{\"name\":\"n\",\"type\":[\"null\",\"x.y.R\"]}]}");
+    BOOST_CHECK_EQUAL(compileJsonSchemaFromString(s.toCanonicalJson()).fingerprint(),
+                      s.fingerprint());
+}
+
 } // namespace schema
 } // namespace avro
 
@@ -470,5 +560,8 @@ init_unit_test_suite(int /*argc*/, char * /*argv*/[]) {
     ADD_PARAM_TEST(ts, avro::schema::testMalformedLogicalTypes,
                    avro::schema::malformedLogicalTypes);
     ts->add(BOOST_TEST_CASE(&avro::schema::testCompactSchemas));
+    ts->add(BOOST_TEST_CASE(&avro::schema::testNameIndex));
+    ts->add(BOOST_TEST_CASE(&avro::schema::testFieldPath));
+    ts->add(BOOST_TEST_CASE(&avro::schema::testCanonicalForm));
     return ts;
 }
@@ -22,6 +22,9 @@
 #include "Specific.hh"
 #include "Stream.hh"
 
+#include <limits>
+#include <unordered_map>
+
 using std::array;
 using std::map;
 using std::string;
@@ -178,6 +181,144 @@ void testCustom() {
     BOOST_CHECK(b == n);
 }
 
+template<typename T>
+void decodeInto(const T &t, T &actual) {
+    Test tst;
+    tst.encode(t);
+    tst.decode(actual);
+}
+
+void testDecodeInPlace() {
+    const string longString(100, 'x');
+    vector<string> v1(3, longString);
+    vector<string> v;
+    decodeInto(v1, v);
+    BOOST_CHECK(v == v1);
+    const char *p = v[1].data();
+    vector<string> v2(2, string(50, 'y'));
+    decodeInto(v2, v);
+    BOOST_CHECK(v == v2);
+    BOOST_CHECK(v[1].data() == p);
+    decodeInto(v1, v);
+    BOOST_CHECK(v == v1);
+
+    map<string, vector<int32_t>> m1;
+    m1["a"] = vector<int32_t>(10, 1);
+    m1["b"] = vector<int32_t>(5, 2);
+    map<string, vector<int32_t>> m;
+    m["stale"] = vector<int32_t>(1, 3);
+    decodeInto(m1, m);
+    BOOST_CHECK(m == m1);
+    const int32_t *q = m["a"].data();
+    map<string, vector<int32_t>> m2;
+    m2["a"] = vector<int32_t>(8, 4);
+    m2["c"] = vector<int32_t>(2, 5);
+    decodeInto(m2, m);
+    BOOST_CHECK(m == m2);
+    m1["c"] = m2["c"];
+    decodeInto(m1, m);
+    BOOST_CHECK(m == m1);
+    BOOST_CHECK(m["a"].data() == q);
+
+    map<string, map<string, int32_t>> n1;
+    n1["x"]["p"] = 1;
+    n1["x"]["q"] = 2;
+    n1["y"]["r"] = 3;
+    map<string, map<string, int32_t>> n;
+    n["y"]["s"] = 4;
+    n["z"]["t"] = 5;
+    decodeInto(n1, n);
+    BOOST_CHECK(n == n1);
+}
+
+void testMapContainers() {
+    std::unordered_map<string, vector<int32_t>> u1;
+    u1["a"] = vector<int32_t>(10, 1);
+    u1["b"] = vector<int32_t>(5, 2);
+    std::unordered_map<string, vector<int32_t>> u;
+    u["stale"] = vector<int32_t>(1, 3);
+    u["a"] = vector<int32_t>(20, 0);
+    const int32_t *q = u["a"].data();
+    decodeInto(u1, u);
+    BOOST_CHECK(u == u1);
+    BOOST_CHECK(u["a"].data() == q);
+
+    vector<std::pair<string, int32_t>> f1;
+    f1.emplace_back("b", 1);
+    f1.emplace_back("a", 2);
+    vector<std::pair<string, int32_t>> f = encodeAndDecode(f1);
+    BOOST_CHECK(f == f1);
+
+    // A flat map holds the same encoding as any other map.
+    map<string, int32_t> m;
+    Test tst;
+    tst.encode(f1);
+    tst.decode(m);
+    BOOST_CHECK_EQUAL(m.size(), 2);
+    BOOST_CHECK_EQUAL(m["a"], 2);
+    BOOST_CHECK_EQUAL(m["b"], 1);
+
+    // A key repeated in the encoding keeps its last value and still
+    // displaces the keys that are absent.
+    vector<std::pair<string, int32_t>> d1;
+    d1.emplace_back("a", 1);
+    d1.emplace_back("a", 3);
+    Test dup;
+    dup.encode(d1);
+    m["b"] = 1;
+    dup.decode(m);
+    BOOST_CHECK_EQUAL(m.size(), 1);
+    BOOST_CHECK_EQUAL(m["a"], 3);
+    std::unordered_map<string, int32_t> um;
+    um["a"] = 0;
+    um["b"] = 0;
+    dup.decode(um);
+    BOOST_CHECK_EQUAL(um.size(), 1);
+    BOOST_CHECK_EQUAL(um["a"], 3);
+}
+
+template<typename T>
+void checkEncodedSize(const T &t) {
+    unique_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    avro::encode(*e, t);
+    e->flush();
+    BOOST_CHECK_EQUAL(avro::encodedSize(t), os->byteCount());
+}
+
+void testEncodedSize() {
+    const int64_t longs[] = {0, 1, -1, 63, -64, 64, -65, 8191, 8192,
+                             std::numeric_limits<int32_t>::max(),
+                             std::numeric_limits<int64_t>::min(),
+                             std::numeric_limits<int64_t>::max()};
+    for (int64_t l : longs) {
+        checkEncodedSize(l);
+        checkEncodedSize(static_cast<int32_t>(l));
+    }
+    checkEncodedSize(true);
+    checkEncodedSize(1.5f);
+    checkEncodedSize(1.5);
+    checkEncodedSize(avro::null());
+    checkEncodedSize(string());
+    checkEncodedSize(string(200, 'x'));
+    checkEncodedSize(vector<uint8_t>(70, 1));
+    array<uint8_t, 5> f = {{1, 7, 23, 47, 83}};
+    checkEncodedSize(f);
+    checkEncodedSize(vector<int32_t>());
+    checkEncodedSize(vector<int64_t>(100, -1000));
+    checkEncodedSize(vector<bool>(3, true));
+    map<string, vector<string>> m;
+    m["a"] = vector<string>(2, "xyz");
+    m[string(130, 'b')] = vector<string>();
+    checkEncodedSize(m);
+
+    // C's codec_traits have no encodedSize(), so C is encoded to find out.
+    BOOST_CHECK(!has_encoded_size<C>::value);
+    BOOST_CHECK(has_encoded_size<vector<C>>::value);
+    checkEncodedSize(vector<C>(3, C(-100, 1LL << 40)));
+}
+
 } // namespace specific
 } // namespace avro
 
@@ -197,6 +338,9 @@ init_unit_test_suite(int /*argc*/, char * /*argv*/[]) {
     ts->add(BOOST_TEST_CASE(avro::specific::testArray));
     ts->add(BOOST_TEST_CASE(avro::specific::testBoolArray));
     ts->add(BOOST_TEST_CASE(avro::specific::testMap));
+    ts->add(BOOST_TEST_CASE(avro::specific::testMapContainers));
     ts->add(BOOST_TEST_CASE(avro::specific::testCustom));
+    ts->add(BOOST_TEST_CASE(avro::specific::testDecodeInPlace));
+    ts->add(BOOST_TEST_CASE(avro::specific::testEncodedSize));
     return ts;
 }
@@ -133,6 +133,53 @@ void testNonEmpty2(const TestData &td) {
     Verify1()(*is, td.dataSize);
 }
 
+template<typename F, typename V>
+void testNonEmpty_growingMemoryStream(const TestData &td) {
+    std::unique_ptr<OutputStream> os = memoryOutputStream(td.chunkSize / 10,
+                                                          td.chunkSize * 4);
+    F()
+    (*os, td.dataSize);
+
+    std::unique_ptr<InputStream> is = memoryInputStream(*os);
+    V()
+    (*is, td.dataSize);
+    BOOST_CHECK_EQUAL(is->byteCount(), td.dataSize);
+}
+
+void testMemoryStreamReset(const TestData &td) {
+    std::unique_ptr<OutputStream> os = memoryOutputStream(td.chunkSize);
+    for (int i = 0; i < 3; ++i) {
+        Fill1()(*os, td.dataSize);
+        BOOST_CHECK_EQUAL(os->byteCount(), td.dataSize);
+        std::unique_ptr<InputStream> is = memoryInputStream(*os);
+        Verify1()(*is, td.dataSize);
+        BOOST_CHECK_EQUAL(snapshot(*os)->size(), td.dataSize);
+        resetMemoryOutputStream(*os);
+        BOOST_CHECK_EQUAL(os->byteCount(), 0);
+        std::unique_ptr<InputStream> empty = memoryInputStream(*os);
+        CheckEmpty1()(*empty);
+    }
+}
+
+void testMemoryChunkPool() {
+    MemoryChunkPoolPtr pool = std::make_shared<MemoryChunkPool>(100, 4);
+    {
+        std::unique_ptr<OutputStream> os = memoryOutputStream(pool);
+        Fill1()(*os, 1000);
+        std::unique_ptr<InputStream> is = memoryInputStream(*os);
+        Verify1()(*is, 1000);
+    }
+    BOOST_CHECK_EQUAL(pool->pooled(), 4);
+    {
+        std::unique_ptr<OutputStream> os = memoryOutputStream(pool);
+        Fill1()(*os, 250);
+        BOOST_CHECK_EQUAL(pool->pooled(), 1);
+        std::unique_ptr<InputStream> is = memoryInputStream(*os);
+        Verify1()(*is, 250);
+    }
+    BOOST_CHECK_EQUAL(pool->pooled(), 4);
+}
+
 static const char filename[] = "test_str.bin";
 
 struct FileRemover {
@@ -205,6 +252,21 @@ init_unit_test_suite(int /*argc*/, char * /*argv*/[]) {
         avro::stream::data,
         avro::stream::data + sizeof(avro::stream::data) / sizeof(avro::stream::data[0])));
 
+    ts->add(BOOST_PARAM_TEST_CASE(
+        (&avro::stream::testNonEmpty_growingMemoryStream<avro::stream::Fill1,
+                                                         avro::stream::Verify1>),
+        avro::stream::data,
+        avro::stream::data + sizeof(avro::stream::data) / sizeof(avro::stream::data[0])));
+    ts->add(BOOST_PARAM_TEST_CASE(
+        (&avro::stream::testNonEmpty_growingMemoryStream<avro::stream::Fill2,
+                                                         avro::stream::Verify2>),
+        avro::stream::data,
+        avro::stream::data + sizeof(avro::stream::data) / sizeof(avro::stream::data[0])));
+    ts->add(BOOST_PARAM_TEST_CASE(&avro::stream::testMemoryStreamReset,
+                                  avro::stream::data,
+                                  avro::stream::data + sizeof(avro::stream::data) / sizeof(avro::stream::data[0])));
+    ts->add(BOOST_TEST_CASE(&avro::stream::testMemoryChunkPool));
+
     ts->add(BOOST_PARAM_TEST_CASE(&avro::stream::testNonEmpty2,
                                   avro::stream::data,
                                   avro::stream::data + sizeof(avro::stream::data) / sizeof(avro::stream::data[0])));
@@ -23,6 +23,9 @@
 #ifdef HAVE_BOOST_ASIO
 #include <boost/asio.hpp>
 #endif
+#include "Decoder.hh"
+#include "Encoder.hh"
+#include "buffer/BufferChunkStream.hh"
 #include "buffer/BufferPrint.hh"
 #include "buffer/BufferReader.hh"
 #include "buffer/BufferStream.hh"
@@ -99,6 +102,138 @@ void addDataToBuffer(OutputBuffer &buf, size_t size) {
     buf.writeTo(data.c_str(), data.size());
 }
 
+class CountingAllocator : public detail::BlockAllocator {
+public:
+    CountingAllocator() : allocated_(0), blocks_(0) {}
+
+    detail::data_type *allocate(detail::size_type size) override {
+        allocated_ += size;
+        ++blocks_;
+        return new detail::data_type[size];
+    }
+
+    void deallocate(detail::data_type *block, detail::size_type size) override {
+        allocated_ -= size;
+        --blocks_;
+        delete[] block;
+    }
+
+    size_t allocated_;
+    int blocks_;
+};
+
+class NullAllocator : public detail::BlockAllocator {
+public:
+    detail::data_type *allocate(detail::size_type) override {
+        return nullptr;
+    }
+
+    void deallocate(detail::data_type *, detail::size_type) override {}
+};
+
+void TestBlockPolicy() {
+    BOOST_TEST_MESSAGE("TestBlockPolicy");
+    {
+        // blocks double in size up to the maximum
+        OutputBuffer ob(OutputBuffer::BlockPolicy(1024, 8192, true));
+        addDataToBuffer(ob, 1024 + 2048 + 4096 + 8192 + 8192);
+        BOOST_CHECK_EQUAL(ob.numDataChunks(), 5);
+        BOOST_CHECK_EQUAL(ob.freeSpace(), 0U);
+
+        InputBuffer ib(ob);
+        InputBuffer::const_iterator iter = ib.begin();
+        BOOST_CHECK_EQUAL(iter->size(), 1024U);
+        ++iter;
+        BOOST_CHECK_EQUAL(iter->size(), 2048U);
+        ++iter;
+        BOOST_CHECK_EQUAL(iter->size(), 4096U);
+        ++iter;
+        BOOST_CHECK_EQUAL(iter->size(), 8192U);
+        ++iter;
+        BOOST_CHECK_EQUAL(iter->size(), 8192U);
+    }
+
+    {
+        // reservations are split within the minimum and maximum
+        OutputBuffer ob(OutputBuffer::BlockPolicy(256, 1 << 20, false), 3 << 20);
+        BOOST_CHECK_EQUAL(ob.numChunks(), 3);
+        BOOST_CHECK_EQUAL(ob.freeSpace(), 3U << 20);
+    }
+
+    boost::shared_ptr<CountingAllocator> allocator(new CountingAllocator);
+    {
+        OutputBuffer ob(OutputBuffer::BlockPolicy(4096, 4096, false, allocator));
+        addDataToBuffer(ob, 10000);
+        BOOST_CHECK_EQUAL(allocator->blocks_, 3);
+        BOOST_CHECK_EQUAL(allocator->allocated_, 3 * 4096U);
+
+        // blocks stay alive as long as some buffer refers to them
+        InputBuffer ib = ob.extractData(5000);
+        OutputBuffer copy = ob.clone();
+        ob = OutputBuffer();
+        BOOST_CHECK_EQUAL(allocator->blocks_, 3);
+        BOOST_CHECK_EQUAL(ib.size(), 5000U);
+        BOOST_CHECK_EQUAL(copy.size(), 5000U);
+
+        // the clone keeps the policy of the original
+        addDataToBuffer(copy, 4096);
+        BOOST_CHECK_EQUAL(allocator->blocks_, 4);
+    }
+    BOOST_CHECK_EQUAL(allocator->blocks_, 0);
+    BOOST_CHECK_EQUAL(allocator->allocated_, 0U);
+
+    {
+        // a zero minimum is taken as one byte, so writes still make progress
+        OutputBuffer::BlockPolicy policy(0, 0, false);
+        BOOST_CHECK_EQUAL(policy.minBlockSize, 1U);
+        BOOST_CHECK_EQUAL(policy.maxBlockSize, 1U);
+        OutputBuffer ob(policy);
+        addDataToBuffer(ob, 3);
+        BOOST_CHECK_EQUAL(ob.size(), 3U);
+        BOOST_CHECK_EQUAL(ob.numDataChunks(), 3);
+    }
+
+    {
+        // an allocator that returns null fails the write
+        boost::shared_ptr<NullAllocator> nullAllocator(new NullAllocator);
+        OutputBuffer ob(OutputBuffer::BlockPolicy(4096, 4096, false, nullAllocator));
+        BOOST_CHECK_THROW(addDataToBuffer(ob, 10), std::bad_alloc);
+        BOOST_CHECK_EQUAL(ob.size(), 0U);
+    }
+}
+
+void TestSingleThreadedBlocks() {
+    BOOST_TEST_MESSAGE("TestSingleThreadedBlocks");
+    boost::shared_ptr<CountingAllocator> allocator(new CountingAllocator);
+    {
+        OutputBuffer ob(OutputBuffer::BlockPolicy(kMinBlockSize, kMaxBlockSize,
+                                                  false, allocator, false));
+        std::string data = makeString(3 * kMinBlockSize);
+        ob.writeTo(data.c_str(), data.size());
+        BOOST_CHECK_EQUAL(allocator->blocks_, 3);
+
+        std::vector<InputBuffer> copies;
+        for (int i = 0; i < 10; ++i) {
+            copies.push_back(InputBuffer(ob));
+        }
+        InputBuffer first = ob.extractData(kMinBlockSize + 10);
+        InputBuffer rest = ob.extractData();
+        copies.clear();
+        BOOST_CHECK_EQUAL(allocator->blocks_, 3);
+
+        OutputBuffer joined;
+        joined.append(first);
+        joined.append(rest);
+        first = InputBuffer();
+        rest = InputBuffer();
+
+        avro::istream is(joined);
+        std::string result((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+        BOOST_CHECK_EQUAL(result, data);
+    }
+    BOOST_CHECK_EQUAL(allocator->blocks_, 0);
+}
+
 void TestGrow() {
     BOOST_TEST_MESSAGE("TestGrow");
     {
@@ -1057,6 +1192,82 @@ void TestForeignDiscard() {
     }
 }
 
+void TestChunkStreams() {
+    BOOST_TEST_MESSAGE("TestChunkStreams");
+    const std::string str = makeString(3 * kDefaultBlockSize);
+    OutputBuffer ob;
+    {
+        OutputStreamPtr os = bufferOutputStream(ob);
+        EncoderPtr e = binaryEncoder();
+        e->init(*os);
+        for (int64_t i = 0; i < 1000; ++i) {
+            e->encodeLong(i * 1000003);
+        }
+        e->encodeString(str);
+        e->encodeDouble(3.25);
+        e->flush();
+        BOOST_CHECK_EQUAL(static_cast<size_t>(os->byteCount()), ob.size());
+    }
+
+    {
+        // space handed out but never settled with backup() is not data
+        OutputBuffer unflushed;
+        uint8_t *data;
+        size_t len;
+        {
+            OutputStreamPtr os = bufferOutputStream(unflushed);
+            BOOST_CHECK(os->next(&data, &len));
+            data[0] = 7;
+        }
+        BOOST_CHECK_EQUAL(unflushed.size(), 0U);
+        {
+            OutputStreamPtr os = bufferOutputStream(unflushed);
+            BOOST_CHECK(os->next(&data, &len));
+            data[0] = 7;
+            os->backup(len - 1);
+        }
+        BOOST_CHECK_EQUAL(unflushed.size(), 1U);
+    }
+
+    InputBuffer ib = ob.extractData();
+#ifndef _WIN32
+    // the encoded message can be sent as is
+    std::vector<struct iovec> iov;
+    toIovec(ib, iov);
+    size_t total = 0;
+    for (auto &v : iov) {
+        total += v.iov_len;
+    }
+    BOOST_CHECK_EQUAL(total, ib.size());
+#endif
+
+    {
+        InputStreamPtr is = bufferInputStream(ib);
+        DecoderPtr d = binaryDecoder();
+        d->init(*is);
+        for (int64_t i = 0; i < 1000; ++i) {
+            BOOST_CHECK_EQUAL(d->decodeLong(), i * 1000003);
+        }
+        BOOST_CHECK_EQUAL(d->decodeString(), str);
+        BOOST_CHECK_EQUAL(d->decodeDouble(), 3.25);
+        d->drain();
+        BOOST_CHECK_EQUAL(is->byteCount(), ib.size());
+        const uint8_t *data;
+        size_t len;
+        BOOST_CHECK(!is->next(&data, &len));
+    }
+
+    {
+        InputStreamPtr is = bufferInputStream(ib);
+        is->skip(ib.size() - 9);
+        BOOST_CHECK_EQUAL(is->byteCount(), ib.size() - 9);
+        DecoderPtr d = binaryDecoder();
+        d->init(*is);
+        d->skipFixed(1);
+        BOOST_CHECK_EQUAL(d->decodeDouble(), 3.25);
+    }
+}
+
 void TestPrinter() {
     BOOST_TEST_MESSAGE("TestPrinter");
     {
@@ -1071,6 +1282,8 @@ struct BufferTestSuite : public boost::unit_test::test_suite {
     BufferTestSuite() : boost::unit_test::test_suite("BufferTestSuite") {
         add(BOOST_TEST_CASE(TestReserve));
         add(BOOST_TEST_CASE(TestGrow));
+        add(BOOST_TEST_CASE(TestBlockPolicy));
+        add(BOOST_TEST_CASE(TestSingleThreadedBlocks));
         add(BOOST_TEST_CASE(TestDiscard));
         add(BOOST_TEST_CASE(TestConvertToInput));
         add(BOOST_TEST_CASE(TestExtractToInput));
@@ -1090,6 +1303,7 @@ struct BufferTestSuite : public boost::unit_test::test_suite {
         add(BOOST_TEST_CASE(TestForeign));
         add(BOOST_TEST_CASE(TestForeignDiscard));
         add(BOOST_TEST_CASE(TestPrinter));
+        add(BOOST_TEST_CASE(TestChunkStreams));
     }
 };
 